@@ -4,10 +4,12 @@
 #include "Util.h"
 #include "MoveGenerator.h"
 #include "Evaluator.h"
+#include "OpeningBook.h"
 #include "Search.h"
 #include "MoveParser.h"
 #include <cstring>
 #include <string>
+#include <thread>
 
 #ifndef wasm
 #include "CLI.h"
@@ -27,7 +29,7 @@ EMSCRIPTEN_KEEPALIVE
 void init() {
     board.hashCodes.initialize();
     board.setStartingPosition();
-    Search::tt.loadOpenings(board);
+    OpeningBook::load();
 }
 
 EMSCRIPTEN_KEEPALIVE
@@ -59,19 +61,19 @@ char *unmove() {
 EMSCRIPTEN_KEEPALIVE
 char *listPieces() {
     std::string string = "White pieces: ";
-    for (Piece &piece: board.whitePieces) {
+    for (int i = 0; i < board.pieceCount[Pieces::WHITE]; ++i) {
         string += "[";
-        string += Util::pieceToString(piece.type, Pieces::WHITE);
+        string += Util::pieceToString(board.pieceTypes[Pieces::WHITE][i], Pieces::WHITE);
         string += ", ";
-        string += std::to_string(piece.position);
+        string += std::to_string(board.piecePositions[Pieces::WHITE][i]);
         string += "] ";
     }
     string += "\nBlack pieces:";
-    for (Piece &piece: board.blackPieces) {
+    for (int i = 0; i < board.pieceCount[Pieces::BLACK]; ++i) {
         string += "[";
-        string += Util::pieceToString(piece.type, Pieces::BLACK);
+        string += Util::pieceToString(board.pieceTypes[Pieces::BLACK][i], Pieces::BLACK);
         string += ", ";
-        string += std::to_string(piece.position);
+        string += std::to_string(board.piecePositions[Pieces::BLACK][i]);
         string += "] ";
     }
     string += "\n";
@@ -85,7 +87,8 @@ char *listPieces() {
 EMSCRIPTEN_KEEPALIVE
 char *getMoves() {
     std::string string;
-    std::vector<Move> moves = MoveGenerator::pseudoLegalMoves(board);
+    MoveList moves;
+    MoveGenerator::pseudoLegalMoves(board, moves);
 
     bool empty = true;
 
@@ -197,7 +200,8 @@ int runPerft(int depth, const char *fen) {
     ChessBoard perftBoard;
     perftBoard.setPosition(fen);
 
-    return MoveGenerator::perft(depth, perftBoard);
+    return MoveGenerator::perftParallel(depth, perftBoard,
+                                        static_cast<int>(std::thread::hardware_concurrency()));
 }
 }
 #endif
@@ -0,0 +1,143 @@
+#include "Bitboards.h"
+
+#include <random>
+
+std::array<uint64_t, 64> Bitboards::knightAttackTable{};
+std::array<uint64_t, 64> Bitboards::kingAttackTable{};
+std::array<std::array<uint64_t, 64>, 2> Bitboards::pawnAttackTable{};
+std::array<std::array<uint64_t, 64>, 64> Bitboards::lineTable{};
+
+std::array<Bitboards::Magic, 64> Bitboards::rookMagics{};
+std::array<Bitboards::Magic, 64> Bitboards::bishopMagics{};
+std::array<uint64_t, 102400> Bitboards::rookAttackTable{};
+std::array<uint64_t, 5248> Bitboards::bishopAttackTable{};
+
+// {rank step, file step} with rank 0 = 8th rank, matching the square numbering
+static constexpr std::array<std::array<int, 2>, 4> ROOK_DIRECTIONS = {{{-1, 0}, {1, 0}, {0, -1}, {0, 1}}};
+static constexpr std::array<std::array<int, 2>, 4> BISHOP_DIRECTIONS = {{{-1, -1}, {-1, 1}, {1, -1}, {1, 1}}};
+
+uint64_t Bitboards::slidingAttacks(const int_fast8_t square, const uint64_t occupied,
+                                   const std::array<std::array<int, 2>, 4> &directions) {
+    uint64_t attacks = 0;
+    for (const auto &[rankStep, fileStep]: directions) {
+        int rank = square / 8 + rankStep;
+        int file = square % 8 + fileStep;
+        while (rank >= 0 && rank < 8 && file >= 0 && file < 8) {
+            const int_fast8_t target = rank * 8 + file;
+            attacks |= bit(target);
+            if (occupied & bit(target)) break;
+            rank += rankStep;
+            file += fileStep;
+        }
+    }
+    return attacks;
+}
+
+void Bitboards::initMagics(std::array<Magic, 64> &magics, uint64_t *table,
+                           const std::array<std::array<int, 2>, 4> &directions) {
+    std::mt19937_64 rng(4985520066906672935ULL);
+    std::uniform_int_distribution<uint64_t> dist;
+
+    for (int_fast8_t square = 0; square < 64; ++square) {
+        // the relevant occupancy mask excludes the edge square of each ray
+        uint64_t mask = 0;
+        for (const auto &[rankStep, fileStep]: directions) {
+            int rank = square / 8 + rankStep;
+            int file = square % 8 + fileStep;
+            while (rank + rankStep >= 0 && rank + rankStep < 8 && file + fileStep >= 0 && file + fileStep < 8) {
+                mask |= bit(rank * 8 + file);
+                rank += rankStep;
+                file += fileStep;
+            }
+        }
+
+        const int bits = std::popcount(mask);
+        const int size = 1 << bits;
+
+        // enumerate every subset of the mask with the Carry-Rippler trick
+        std::array<uint64_t, 4096> occupancies{};
+        std::array<uint64_t, 4096> reference{};
+        uint64_t occupied = 0;
+        for (int i = 0; i < size; ++i) {
+            occupancies[i] = occupied;
+            reference[i] = slidingAttacks(square, occupied, directions);
+            occupied = (occupied - mask) & mask;
+        }
+
+        Magic &m = magics[square];
+        m.mask = mask;
+        m.shift = 64 - bits;
+        m.attacks = table;
+
+        // search for a magic that maps every subset without harmful collisions
+        while (true) {
+            m.magic = dist(rng) & dist(rng) & dist(rng);
+            if (std::popcount((mask * m.magic) >> 56) < 6) continue;
+
+            std::fill_n(table, size, 0ULL);
+            bool collision = false;
+            for (int i = 0; i < size && !collision; ++i) {
+                const int index = ((occupancies[i] & mask) * m.magic) >> m.shift;
+                if (table[index] == 0) table[index] = reference[i];
+                else if (table[index] != reference[i]) collision = true;
+            }
+            if (!collision) break;
+        }
+
+        table += size;
+    }
+}
+
+void Bitboards::init() {
+    static bool initialized = false;
+    if (initialized) return;
+    initialized = true;
+
+    for (int_fast8_t square = 0; square < 64; ++square) {
+        const int rank = square / 8;
+        const int file = square % 8;
+
+        constexpr std::array<std::array<int, 2>, 8> knightSteps = {
+            {{-2, -1}, {-2, 1}, {-1, -2}, {-1, 2}, {1, -2}, {1, 2}, {2, -1}, {2, 1}}
+        };
+        for (const auto &[rankStep, fileStep]: knightSteps) {
+            const int r = rank + rankStep;
+            const int f = file + fileStep;
+            if (r >= 0 && r < 8 && f >= 0 && f < 8) knightAttackTable[square] |= bit(r * 8 + f);
+        }
+
+        constexpr std::array<std::array<int, 2>, 8> kingSteps = {
+            {{-1, -1}, {-1, 0}, {-1, 1}, {0, -1}, {0, 1}, {1, -1}, {1, 0}, {1, 1}}
+        };
+        for (const auto &[rankStep, fileStep]: kingSteps) {
+            const int r = rank + rankStep;
+            const int f = file + fileStep;
+            if (r >= 0 && r < 8 && f >= 0 && f < 8) kingAttackTable[square] |= bit(r * 8 + f);
+        }
+
+        // white pawns attack towards rank 8 (lower indices), black towards rank 1
+        if (rank > 0) {
+            if (file > 0) pawnAttackTable[Pieces::WHITE][square] |= bit(square - 9);
+            if (file < 7) pawnAttackTable[Pieces::WHITE][square] |= bit(square - 7);
+        }
+        if (rank < 7) {
+            if (file > 0) pawnAttackTable[Pieces::BLACK][square] |= bit(square + 7);
+            if (file < 7) pawnAttackTable[Pieces::BLACK][square] |= bit(square + 9);
+        }
+    }
+
+    initMagics(rookMagics, rookAttackTable.data(), ROOK_DIRECTIONS);
+    initMagics(bishopMagics, bishopAttackTable.data(), BISHOP_DIRECTIONS);
+
+    // on an empty board the attack sets of two aligned squares overlap exactly
+    // on their shared line, the parallel leftover rays never intersect
+    for (int_fast8_t a = 0; a < 64; ++a) {
+        for (int_fast8_t b = 0; b < 64; ++b) {
+            if (a == b) continue;
+            if (rookAttacks(0, a) & bit(b))
+                lineTable[a][b] = (rookAttacks(0, a) & rookAttacks(0, b)) | bit(a) | bit(b);
+            else if (bishopAttacks(0, a) & bit(b))
+                lineTable[a][b] = (bishopAttacks(0, a) & bishopAttacks(0, b)) | bit(a) | bit(b);
+        }
+    }
+}
@@ -0,0 +1,88 @@
+#ifndef CHESSENGINE_BITBOARDS_H
+#define CHESSENGINE_BITBOARDS_H
+
+#include <array>
+#include <bit>
+#include <cstdint>
+#include "Piece.h"
+
+// 64-bit occupancy masks and attack tables, indexed with the same 0..63 square
+// numbering as ChessBoard::squares (0 = a8, 63 = h1).
+class Bitboards {
+public:
+    // Builds the leaper tables and the magic sliding attack tables. Safe to call
+    // more than once, only the first call does work.
+    static void init();
+
+    static constexpr uint64_t bit(const int_fast8_t square) { return 1ULL << square; }
+
+    // Removes the lowest set bit from the board and returns its square.
+    static int_fast8_t popLsb(uint64_t &board) {
+        const int_fast8_t square = std::countr_zero(board);
+        board &= board - 1;
+        return square;
+    }
+
+    static uint64_t knightAttacks(const int_fast8_t square) { return knightAttackTable[square]; }
+
+    static uint64_t kingAttacks(const int_fast8_t square) { return kingAttackTable[square]; }
+
+    // Squares attacked by a pawn of the given color standing on the given square.
+    static uint64_t pawnAttacks(const Pieces::Color color, const int_fast8_t square) {
+        return pawnAttackTable[color][square];
+    }
+
+    static uint64_t bishopAttacks(const uint64_t occupied, const int_fast8_t square) {
+        const Magic &m = bishopMagics[square];
+        return m.attacks[((occupied & m.mask) * m.magic) >> m.shift];
+    }
+
+    static uint64_t rookAttacks(const uint64_t occupied, const int_fast8_t square) {
+        const Magic &m = rookMagics[square];
+        return m.attacks[((occupied & m.mask) * m.magic) >> m.shift];
+    }
+
+    static uint64_t queenAttacks(const uint64_t occupied, const int_fast8_t square) {
+        return bishopAttacks(occupied, square) | rookAttacks(occupied, square);
+    }
+
+    // The full rank, file or diagonal through both squares, 0 when they are
+    // not aligned. Used for pin rays and check interposition masks.
+    static uint64_t line(const int_fast8_t a, const int_fast8_t b) { return lineTable[a][b]; }
+
+    // Attack set of a non-pawn piece of the given type standing on the given square.
+    static uint64_t attacks(const Pieces::Type type, const uint64_t occupied, const int_fast8_t square) {
+        switch (type) {
+            case Pieces::KNIGHT: return knightAttacks(square);
+            case Pieces::BISHOP: return bishopAttacks(occupied, square);
+            case Pieces::ROOK: return rookAttacks(occupied, square);
+            case Pieces::QUEEN: return queenAttacks(occupied, square);
+            case Pieces::KING: return kingAttacks(square);
+            default: return 0;
+        }
+    }
+
+private:
+    struct Magic {
+        uint64_t mask;
+        uint64_t magic;
+        uint64_t *attacks;
+        int shift;
+    };
+
+    static std::array<uint64_t, 64> knightAttackTable;
+    static std::array<uint64_t, 64> kingAttackTable;
+    static std::array<std::array<uint64_t, 64>, 2> pawnAttackTable;
+    static std::array<std::array<uint64_t, 64>, 64> lineTable;
+
+    static std::array<Magic, 64> rookMagics;
+    static std::array<Magic, 64> bishopMagics;
+    static std::array<uint64_t, 102400> rookAttackTable;
+    static std::array<uint64_t, 5248> bishopAttackTable;
+
+    static uint64_t slidingAttacks(int_fast8_t square, uint64_t occupied, const std::array<std::array<int, 2>, 4> &directions);
+
+    static void initMagics(std::array<Magic, 64> &magics, uint64_t *table, const std::array<std::array<int, 2>, 4> &directions);
+};
+
+#endif //CHESSENGINE_BITBOARDS_H
@@ -1,30 +1,69 @@
 #include "CLI.h"
+#include <algorithm>
+#include <atomic>
+#include <format>
+#include <fstream>
 #include <iostream>
 #include <sstream>
 #include <thread>
 
+#include "Endgame.h"
 #include "MoveGenerator.h"
+#include "OpeningBook.h"
 #include "Search.h"
 #include "MoveParser.h"
 
 namespace Interface {
     void CLI::start() {
         board = ChessBoard();
-        Instruction currentInstruction;
-        currentInstruction.command = invalid;
-        while (currentInstruction.command != quit) {
-            std::string input;
-            std::getline(std::cin, input);
-            currentInstruction = interpret(input);
+        OpeningBook::load();
+        // table generation takes a few seconds, keep it off the command loop;
+        // probes miss until it finishes
+        std::thread(Endgame::init).detach();
+        std::thread worker(&CLI::workerLoop, this);
 
-            readySemaphore.acquire();
+        // the calling thread becomes the stdin reader: it parses every line
+        // and hands it to the worker, so a command flood costs one enqueue
+        // each instead of a thread spawn
+        std::string input;
+        while (std::getline(std::cin, input)) {
+            Instruction instruction = interpret(input);
+            const Command command = instruction.command;
 
-            if (currentInstruction.command != ucinewgame && currentInstruction.command != position){
-                readySemaphore.release();
+            // answered out of band: the worker may be blocked in a timed
+            // search, and a GUI ping or stop must not wait for it
+            if (command == isready) {
+                std::cout << "readyok" << std::endl;
+                continue;
+            }
+            if (command == stop) {
+                stopsRequested.fetch_add(1, std::memory_order_release);
+                search.interrupt();
             }
 
-            std::thread thread(&CLI::handleInstruction, this, currentInstruction);
-            thread.detach();
+            while (!commands.push(std::move(instruction))) std::this_thread::yield();
+            pending.release();
+
+            if (command == quit) break;
+        }
+
+        // stdin may close without a quit, send one ourselves so the worker
+        // wakes up; a duplicate is harmless since the worker exits at the
+        // first. Cut any running search short, then join so queued work is
+        // finished and flushed before teardown begins
+        search.interrupt();
+        while (!commands.push(Instruction(quit, {}))) std::this_thread::yield();
+        pending.release();
+        worker.join();
+    }
+
+    void CLI::workerLoop() {
+        while (true) {
+            pending.acquire();
+            Instruction instruction;
+            if (!commands.pop(instruction)) continue;
+            if (instruction.command == quit) break;
+            handleInstruction(instruction);
         }
     }
 
@@ -36,6 +75,7 @@ namespace Interface {
         while (getline(ss, item, ' ')) {
             strings.push_back(item);
         }
+        if (strings.empty()) return Instruction(invalid, {});
 
         const auto it = commandMap.find(strings[0]);
         const Command command = it != commandMap.end() ? it->second : invalid;
@@ -48,23 +88,42 @@ namespace Interface {
             case uci:
                 std::cout << "id name " << "EngineName" << std::endl;
                 std::cout << "id author " << "Exclusivefrog28" << std::endl;
+                std::cout << "option name Threads type spin default 1 min 1 max 256" << std::endl;
+                std::cout << "option name Hash type spin default 256 min 1 max 65536" << std::endl;
+                std::cout << "option name MultiPV type spin default 1 min 1 max 64" << std::endl;
+                std::cout << "option name Ponder type check default false" << std::endl;
+                std::cout << "option name Tablebase type check default true" << std::endl;
                 std::cout << "uciok" << std::endl;
                 break;
-            case isready: {
-                std::cout << "readyok" << std::endl;
+            case setoption: {
+                if (instr.args.size() >= 4 && instr.args[0] == "name" && instr.args[2] == "value") {
+                    if (instr.args[1] == "Threads") {
+                        Search::threadCount = std::clamp(std::stoi(instr.args[3]), 1, 256);
+                    } else if (instr.args[1] == "Hash") {
+                        Search::tt.resize(std::clamp(std::stoi(instr.args[3]), 1, 65536));
+                    } else if (instr.args[1] == "MultiPV") {
+                        Search::multiPV = std::clamp(std::stoi(instr.args[3]), 1, 64);
+                    } else if (instr.args[1] == "Ponder") {
+                        ponderEnabled = instr.args[3] == "true";
+                    } else if (instr.args[1] == "Tablebase") {
+                        Endgame::enabled = instr.args[3] == "true";
+                    }
+                }
             }
                 break;
             case ucinewgame: {
+                // a leftover ponder search would keep mutating the board
+                // while it is reassigned below
+                stopPondering();
                 Search::tt.clear();
                 board = ChessBoard();
-                readySemaphore.release();
             }
                 break;
             case position: {
+                stopPondering();
                 int startIndex = 1;
                 if (instr.args[0] == "startpos") {
                     board.setStartingPosition();
-                    Search::tt.loadOpenings(board);
                 } else if (instr.args[0] == "fen") {
                     const std::string fen = instr.args[1] + " " +
                                             instr.args[2] + " " +
@@ -80,46 +139,182 @@ namespace Interface {
                         board.makeMove(parseMove(instr.args[i], board));
                     }
                 }
-                readySemaphore.release();
             }
                 break;
             case go: {
                 int timeOut = 0;
+                bool ponder = false;
+                int depthLimit = 0;
+                uint64_t nodeLimit = 0;
+                int wtime = 0, btime = 0, winc = 0, binc = 0;
+                bool clockGiven = false;
+                bool runPerft = false;
+                int perftDepth = 0;
+                int perftThreads = static_cast<int>(std::thread::hardware_concurrency());
 
-                if (!instr.args.empty()) {
-                    const std::string arg = instr.args[0];
-                    if (arg == "movetime") {
-                        timeOut = std::stoi(instr.args[1]);
-                    } else if (arg == "perft") {
-                        const uint64_t hashBefore = board.hashCode;
-                        const int depth = std::stoi(instr.args[1]);
-                        const uint64_t nodes = MoveGenerator::perft(depth, board);
-                        std::cout << nodes << std::endl;
-                        if (board.hashCode != hashBefore) {
-                            std::cout << "Hash mismatch" << std::endl;
-                        }
+                for (size_t i = 0; i < instr.args.size(); ++i) {
+                    const std::string &arg = instr.args[i];
+                    if (arg == "ponder") {
+                        ponder = true;
+                        continue;
+                    }
+                    if (i + 1 >= instr.args.size()) break;
+                    const std::string &value = instr.args[i + 1];
+                    if (arg == "movetime") timeOut = std::stoi(value);
+                    else if (arg == "depth") depthLimit = std::clamp(std::stoi(value), 1, 63);
+                    else if (arg == "nodes") nodeLimit = std::stoull(value);
+                    else if (arg == "wtime") { wtime = std::stoi(value); clockGiven = true; }
+                    else if (arg == "btime") { btime = std::stoi(value); clockGiven = true; }
+                    else if (arg == "winc") { winc = std::stoi(value); clockGiven = true; }
+                    else if (arg == "binc") { binc = std::stoi(value); clockGiven = true; }
+                    else if (arg == "perft") {
+                        runPerft = true;
+                        perftDepth = std::stoi(value);
+                    } else if (arg == "threads") perftThreads = std::stoi(value);
+                    else continue;
+                    ++i;
+                }
+
+                if (runPerft) {
+                    const uint64_t hashBefore = board.hashCode;
+                    const uint64_t nodes = MoveGenerator::perftParallel(perftDepth, board, perftThreads);
+                    std::cout << nodes << std::endl;
+                    if (board.hashCode != hashBefore) {
+                        std::cout << "Hash mismatch" << std::endl;
+                    }
+                    break;
+                }
+
+                // soft budget from the clock: a slice of the remaining time
+                // plus most of the increment, hard ceiling well below flagging
+                int64_t softTime = 0;
+                int64_t hardTime = 0;
+                if (timeOut > 0) {
+                    softTime = timeOut;
+                    hardTime = timeOut;
+                } else if (clockGiven) {
+                    const int remaining = board.sideToMove == WHITE ? wtime : btime;
+                    const int increment = board.sideToMove == WHITE ? winc : binc;
+                    softTime = remaining / 25 + (increment * 3) / 4;
+                    hardTime = std::min<int64_t>(remaining / 3, softTime * 4);
+                    softTime = std::min(softTime, hardTime);
+                }
+
+                if (!ponder) {
+                    // while in book, answer from the mapped records without
+                    // spinning up a search
+                    const Move bookMove = OpeningBook::probe(board);
+                    if (bookMove != NULL_MOVE) {
+                        board.makeMove(bookMove);
+                        std::cout << "bestmove " << bookMove << std::endl;
                         break;
                     }
                 }
 
                 searching = true;
                 search.reset();
+                // a pondering search runs open-ended, the limits only kick in
+                // once ponderhit converts it to our own clock
+                search.setLimits(ponder ? 0 : depthLimit, ponder ? 0 : nodeLimit,
+                                 ponder ? 0 : softTime, ponder ? 0 : hardTime);
                 search.doSearch();
 
-                if (timeOut > 0) {
-                    Move bestMove = search.endSearch(timeOut);
+                if (ponder) {
+                    pondering = true;
+                    lastMoveTime = hardTime > 0 ? (int) hardTime : timeOut;
+                } else if (hardTime > 0 || depthLimit > 0 || nodeLimit > 0) {
+                    // a stop that raced ahead of this handler was cleared by
+                    // the reset above, raise it again now that it can stick
+                    if (stopsRequested.load(std::memory_order_acquire) != stopsSeen) search.interrupt();
+                    // the search stops itself at its limits, the semaphore
+                    // wait just mirrors the hard ceiling
+                    const int wait = hardTime > 0 ? (int) hardTime : 3600000;
+                    lastMoveTime = wait;
+                    const Move bestMove = search.endSearch(wait);
+                    searching = false;
+                    reportBestMove(bestMove);
+                }
+            }
+                break;
+            case ponderhit: {
+                // the predicted move was played, the running ponder search
+                // simply finishes on the normal clock
+                if (pondering) {
+                    pondering = false;
+                    const Move bestMove = search.endSearch(lastMoveTime);
                     searching = false;
-                    board.makeMove(bestMove);
+                    reportBestMove(bestMove);
+                }
+            }
+                break;
+            case analyzefile: {
+                // offline annotation: stream a file of FENs through a pool of
+                // Search instances sharing the warm transposition table, one
+                // JSON line per position
+                if (instr.args.empty()) break;
 
-                    std::cout << "bestmove " << bestMove << std::endl;
+                int depth = 12;
+                uint64_t nodes = 0;
+                int workerCount = 1;
+                std::string outputPath;
+                for (size_t i = 1; i + 1 < instr.args.size(); i += 2) {
+                    if (instr.args[i] == "depth") depth = std::clamp(std::stoi(instr.args[i + 1]), 1, 63);
+                    else if (instr.args[i] == "nodes") nodes = std::stoull(instr.args[i + 1]);
+                    else if (instr.args[i] == "threads") workerCount = std::clamp(std::stoi(instr.args[i + 1]), 1, 256);
+                    else if (instr.args[i] == "output") outputPath = instr.args[i + 1];
+                }
+
+                std::ifstream input(instr.args[0]);
+                if (!input.is_open()) {
+                    std::cerr << "Failed to open " << instr.args[0] << std::endl;
+                    break;
+                }
+                std::vector<std::string> fens;
+                std::string line;
+                while (std::getline(input, line)) {
+                    if (!line.empty()) fens.push_back(line);
+                }
+
+                std::vector<std::string> results(fens.size());
+                std::atomic<size_t> nextIndex = 0;
+
+                auto worker = [&] {
+                    ChessBoard workerBoard;
+                    Search workerSearch(workerBoard);
+                    while (true) {
+                        const size_t index = nextIndex.fetch_add(1);
+                        if (index >= fens.size()) break;
+                        workerBoard.setPosition(fens[index]);
+                        const Search::AnalysisResult result = workerSearch.analyze(depth, nodes);
+                        std::ostringstream bestMove;
+                        bestMove << result.bestMove;
+                        results[index] = std::format(
+                            R"({{"fen":"{}","bestmove":"{}","score":{},"depth":{},"nodes":{}}})",
+                            fens[index], bestMove.str(), result.score, result.depth, result.nodes);
+                    }
+                };
+
+                std::vector<std::thread> workers;
+                for (int i = 0; i < workerCount; ++i) workers.emplace_back(worker);
+                for (std::thread &w: workers) w.join();
+
+                if (outputPath.empty()) {
+                    for (const std::string &result: results) std::cout << result << "\n";
+                    std::cout << std::flush;
+                } else {
+                    std::ofstream output(outputPath);
+                    for (const std::string &result: results) output << result << "\n";
+                    std::cout << "analyzed " << results.size() << " positions" << std::endl;
                 }
             }
                 break;
             case stop: {
+                stopsSeen = stopsRequested.load(std::memory_order_acquire);
                 if (searching) {
-                    Move bestMove = search.endSearch(0);
+                    const Move bestMove = search.endSearch(0);
+                    pondering = false;
                     searching = false;
-                    board.makeMove(bestMove);
+                    if (bestMove != NULL_MOVE) board.makeMove(bestMove);
 
                     std::cout << "bestmove " << bestMove << std::endl;
                 }
@@ -129,4 +324,35 @@ namespace Interface {
                 break;
         }
     }
+
+    void CLI::reportBestMove(const Move &bestMove) {
+        if (bestMove == NULL_MOVE) {
+            std::cout << "bestmove 0000" << std::endl;
+            return;
+        }
+
+        const Move predicted = search.ponderMove();
+        board.makeMove(bestMove);
+
+        if (ponderEnabled && predicted != NULL_MOVE) {
+            std::cout << "bestmove " << bestMove << " ponder " << predicted << std::endl;
+            // start thinking about our reply to the predicted move right away
+            board.makeMove(predicted);
+            pondering = true;
+            searching = true;
+            search.reset();
+            search.setLimits(0, 0, 0, 0);
+            search.doSearch();
+        } else {
+            std::cout << "bestmove " << bestMove << std::endl;
+        }
+    }
+
+    void CLI::stopPondering() {
+        if (pondering) {
+            search.endSearch(0);
+            pondering = false;
+            searching = false;
+        }
+    }
 }
@@ -1,5 +1,7 @@
 #ifndef INTERFACE_H
 #define INTERFACE_H
+#include <array>
+#include <atomic>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -20,14 +22,46 @@ namespace Interface {
 		go,
 		stop,
 		ponderhit,
+		setoption,
+		analyzefile,
 		quit
 	};
 
 	struct Instruction {
-		Command command;
+		Command command = invalid;
 		std::vector<std::string> args;
 	};
 
+	// single-producer single-consumer ring: the reader thread pushes parsed
+	// instructions, the worker pops them, and the two indices are the only
+	// shared state, so neither side ever takes a lock. Each index is written
+	// by exactly one side
+	struct CommandQueue {
+		static constexpr size_t SIZE = 256; //power of two, plenty for a position flood
+		static constexpr size_t MASK = SIZE - 1;
+
+		std::array<Instruction, SIZE> slots{};
+		std::atomic<size_t> head = 0; //next slot to pop, written by the worker
+		std::atomic<size_t> tail = 0; //next slot to push, written by the reader
+
+		// false when the ring is full, the instruction is left untouched
+		bool push(Instruction&&instruction) {
+			const size_t t = tail.load(std::memory_order_relaxed);
+			if (t - head.load(std::memory_order_acquire) == SIZE) return false;
+			slots[t & MASK] = std::move(instruction);
+			tail.store(t + 1, std::memory_order_release);
+			return true;
+		}
+
+		bool pop(Instruction&instruction) {
+			const size_t h = head.load(std::memory_order_relaxed);
+			if (h == tail.load(std::memory_order_acquire)) return false;
+			instruction = std::move(slots[h & MASK]);
+			head.store(h + 1, std::memory_order_release);
+			return true;
+		}
+	};
+
 	const inline std::unordered_map<std::string, Command> commandMap = {
 		{"quit", quit},
 		{"uci", uci},
@@ -36,7 +70,9 @@ namespace Interface {
 		{"position", position},
 		{"go", go},
 		{"stop", stop},
-		{"ponderhit", ponderhit}
+		{"ponderhit", ponderhit},
+		{"setoption", setoption},
+		{"analyzefile", analyzefile}
 	};
 
 	class CLI {
@@ -46,14 +82,37 @@ namespace Interface {
 	private:
 		ChessBoard board;
 
-        std::binary_semaphore readySemaphore{1};
+		CommandQueue commands;
+		// counts queued instructions so the worker sleeps instead of spinning
+		std::counting_semaphore<> pending{0};
+
+		// stop requests are counted, not just flagged: an interrupt that fires
+		// while the worker is still on its way into the go handler would be
+		// wiped by the reset there, so the handler compares the counter after
+		// starting the search and re-raises the interrupt when one slipped by
+		std::atomic<uint64_t> stopsRequested = 0;
+		uint64_t stopsSeen = 0; //only the worker reads and writes this
 
 		static Instruction interpret(const std::string&string);
 
+		// persistent worker draining the command queue; one thread handles
+		// every state-changing command, so they serialize by construction
+		void workerLoop();
+
 		void handleInstruction(const Instruction&instr);
 
         Search search = Search(board);
         bool searching = false;
+
+		// pondering: after bestmove the search keeps running on the predicted
+		// reply, ponderhit converts it into the normal timed search
+		bool ponderEnabled = false;
+		bool pondering = false;
+		int lastMoveTime = 0;
+
+		void reportBestMove(const Move&bestMove);
+
+		void stopPondering();
 	};
 }
 
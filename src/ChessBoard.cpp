@@ -1,6 +1,9 @@
 #include "ChessBoard.h"
+#include "EvaluationValues.h"
 #include "HashCodes.h"
 
+using namespace EvaluationValues;
+
 void ChessBoard::setStartingPosition() {
 	setPosition("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1");
 }
@@ -18,11 +21,42 @@ std::ostream& operator<<(std::ostream&os, const ChessBoard&board) {
 	return os;
 }
 
+Move ChessBoard::expandMove(const PackedMove move) const {
+	if (move == NULL_PACKED_MOVE) return NULL_MOVE;
+
+	const int_fast8_t start = move.start();
+	const int_fast8_t end = move.end();
+
+	// the mover gives the player, the target square the captured piece, and
+	// the geometry settles double pushes and the castle side
+	MoveFlag flag = QUIET;
+	switch (move.kind()) {
+		case PackedMove::EP:
+			flag = ENPASSANT;
+			break;
+		case PackedMove::CASTLE:
+			flag = end > start ? CASTLEKINGSIDE : CASTLEQUEENSIDE;
+			break;
+		default: {
+			const Type victim = squares[end].type;
+			if (victim != EMPTY && victim != KING) flag = static_cast<MoveFlag>(victim);
+			else if (squares[start].type == PAWN && (end - start == 16 || start - end == 16))
+				flag = DOUBLEPAWNPUSH;
+		}
+	}
+
+	return {start, end, move.promotionType(), flag, sideToMove};
+}
+
 void ChessBoard::makeMove(const Move&move) {
-	enPassantHistory.push_back(enPassantSquare);
-	castlingRightHistory.push_back(castlingRights);
-	halfMoveClockHistory.push_back(halfMoveClock);
-	positionHistory.push_back(hashCode);
+	UndoInfo&undo = undoStack[plyCount];
+	undo.move = move;
+	undo.hash = hashCode;
+	undo.castlingRights = castlingRights;
+	undo.enPassantSquare = enPassantSquare;
+	undo.halfMoveClock = halfMoveClock;
+	undo.lastIrreversiblePly = lastIrreversiblePly;
+	repetitions.push(hashCode, plyCount);
 
 	if (move.flag == ENPASSANT) {
 		removePiece(enPassantSquare);
@@ -34,7 +68,7 @@ void ChessBoard::makeMove(const Move&move) {
 
 	if (squares[move.start].type == PAWN || (move.flag > 0)) {
 		halfMoveClock = 0;
-		irreversibleIndices.push_back(positionHistory.size() - 1);
+		lastIrreversiblePly = plyCount;
 	}
 	else halfMoveClock++;
 
@@ -63,13 +97,9 @@ void ChessBoard::makeMove(const Move&move) {
 	sideToMove = invertColor(sideToMove);
 	hashCode ^= hashCodes.blackToMoveCode;
 
-	const Move m = move;
-	moveHistory.push_back(m);
-
-
 	updateCastlingRights(move);
 
-	const auto [blackKingSide, blackQueenSide, whiteKingSide, whiteQueenSide] = castlingRightHistory.back();
+	const auto [blackKingSide, blackQueenSide, whiteKingSide, whiteQueenSide] = undo.castlingRights;
 
 	const uint64_t previousHash = hashCodes.castlingRightCodes[blackKingSide * 8 +
 	                                                           blackQueenSide * 4 +
@@ -81,41 +111,23 @@ void ChessBoard::makeMove(const Move&move) {
 	if (previousHash != newHash) {
 		hashCode ^= previousHash;
 		hashCode ^= newHash;
-		if (irreversibleIndices.empty() || irreversibleIndices.back() != positionHistory.size() - 1)
-			irreversibleIndices.push_back(positionHistory.size() - 1);
+		lastIrreversiblePly = plyCount;
 	}
+
+	plyCount++;
 }
 
 void ChessBoard::unMakeMove() {
-	if (moveHistory.empty()) return;
-
-	if (enPassantSquare != -1) hashCode ^= hashCodes.enPassantFileCode[enPassantSquare % 8];
-	enPassantSquare = enPassantHistory.back();
-	if (enPassantSquare != -1) hashCode ^= hashCodes.enPassantFileCode[enPassantSquare % 8];
-
-	Move lastMove = moveHistory.back();
+	if (plyCount == 0) return;
 
-	const CastlingRights prevCastlingRights = castlingRightHistory.back();
+	const UndoInfo&undo = undoStack[--plyCount];
+	const Move lastMove = undo.move;
+	repetitions.pop(undo.hash, plyCount);
 
-	if (castlingRights != prevCastlingRights) {
-		hashCode ^= hashCodes.castlingRightCodes[castlingRights.blackKingSide * 8 + castlingRights.blackQueenSide * 4 +
-		                                         castlingRights.whiteKingSide * 2 + castlingRights.whiteQueenSide];
-		hashCode ^= hashCodes.castlingRightCodes[prevCastlingRights.blackKingSide * 8 +
-		                                         prevCastlingRights.blackQueenSide * 4 +
-		                                         prevCastlingRights.whiteKingSide * 2 +
-		                                         prevCastlingRights.whiteQueenSide];
-		castlingRights = prevCastlingRights;
-	}
-
-	halfMoveClock = halfMoveClockHistory.back();
-
-	moveHistory.pop_back();
-	castlingRightHistory.pop_back();
-	enPassantHistory.pop_back();
-	halfMoveClockHistory.pop_back();
-
-	if (!irreversibleIndices.empty() && irreversibleIndices.back() == positionHistory.size() - 1) irreversibleIndices.pop_back();
-	positionHistory.pop_back();
+	enPassantSquare = undo.enPassantSquare;
+	castlingRights = undo.castlingRights;
+	halfMoveClock = undo.halfMoveClock;
+	lastIrreversiblePly = undo.lastIrreversiblePly;
 
 	if (lastMove.player == BLACK) fullMoveClock--;
 
@@ -142,23 +154,120 @@ void ChessBoard::unMakeMove() {
 		}
 	}
 
+	sideToMove = invertColor(sideToMove);
+	hashCode = undo.hash;
+}
+
+uint64_t ChessBoard::attackersTo(const int_fast8_t square, const uint64_t occupied) const {
+	return (Bitboards::pawnAttacks(WHITE, square) & pieces(BLACK, PAWN))
+	       | (Bitboards::pawnAttacks(BLACK, square) & pieces(WHITE, PAWN))
+	       | (Bitboards::knightAttacks(square) & (pieces(WHITE, KNIGHT) | pieces(BLACK, KNIGHT)))
+	       | (Bitboards::kingAttacks(square) & (pieces(WHITE, KING) | pieces(BLACK, KING)))
+	       | (Bitboards::bishopAttacks(occupied, square) &
+	          (pieces(WHITE, BISHOP) | pieces(BLACK, BISHOP) | pieces(WHITE, QUEEN) | pieces(BLACK, QUEEN)))
+	       | (Bitboards::rookAttacks(occupied, square) &
+	          (pieces(WHITE, ROOK) | pieces(BLACK, ROOK) | pieces(WHITE, QUEEN) | pieces(BLACK, QUEEN)));
+}
+
+// exchange values by Type, on the mg_value scale with a king no exchange can
+// ever win back
+constexpr std::array<int, 7> seeValue = {0, 820, 3370, 3650, 4770, 10250, 100000};
+
+int ChessBoard::see(const Move&move) const {
+	const int_fast8_t target = move.end;
+	std::array<int, 32> gain{};
+	int depth = 0;
+
+	uint64_t occupied = this->occupied();
+
+	Type victim = (move.flag > 0 && move.flag < 6) ? static_cast<Type>(move.flag) : EMPTY;
+	if (move.flag == ENPASSANT) {
+		victim = PAWN;
+		occupied ^= Bitboards::bit(enPassantSquare);
+	}
+	gain[0] = seeValue[victim];
+
+	Type attacker = squares[move.start].type;
+	occupied ^= Bitboards::bit(move.start);
+	Color side = invertColor(move.player);
+
+	// recomputing the attacker set after each removal uncovers x-ray attacks
+	// through the vacated squares
+	uint64_t attackers = attackersTo(target, occupied) & occupied;
+
+	while (true) {
+		const uint64_t sideAttackers = attackers & occupancy[side] & occupied;
+		if (!sideAttackers) break;
+
+		Type leastValuable = EMPTY;
+		uint64_t leastValuableBit = 0;
+		for (const Type type: {PAWN, KNIGHT, BISHOP, ROOK, QUEEN, KING}) {
+			const uint64_t subset = sideAttackers & bitboards[side][type];
+			if (subset) {
+				leastValuable = type;
+				leastValuableBit = subset & -subset;
+				break;
+			}
+		}
+
+		depth++;
+		gain[depth] = seeValue[attacker] - gain[depth - 1];
+		// neither continuing nor standing pat can turn a lost exchange around
+		if (std::max(-gain[depth - 1], gain[depth]) < 0) break;
+
+		occupied ^= leastValuableBit;
+		attacker = leastValuable;
+		side = invertColor(side);
+		attackers = attackersTo(target, occupied) & occupied;
+	}
+
+	for (; depth > 0; --depth) gain[depth - 1] = -std::max(-gain[depth - 1], gain[depth]);
+
+	return gain[0];
+}
+
+// passes the turn to the opponent without moving a piece, used by null move
+// pruning in the search - counts as irreversible so repetition detection
+// never matches across it
+void ChessBoard::makeNullMove() {
+	UndoInfo&undo = undoStack[plyCount];
+	undo.move = NULL_MOVE;
+	undo.hash = hashCode;
+	undo.castlingRights = castlingRights;
+	undo.enPassantSquare = enPassantSquare;
+	undo.halfMoveClock = halfMoveClock;
+	undo.lastIrreversiblePly = lastIrreversiblePly;
+	repetitions.push(hashCode, plyCount);
+	lastIrreversiblePly = plyCount;
+	plyCount++;
+
+	if (enPassantSquare != -1) {
+		hashCode ^= hashCodes.enPassantFileCode[enPassantSquare % 8];
+		enPassantSquare = -1;
+	}
+
 	sideToMove = invertColor(sideToMove);
 	hashCode ^= hashCodes.blackToMoveCode;
 }
 
+void ChessBoard::unMakeNullMove() {
+	const UndoInfo&undo = undoStack[--plyCount];
+	repetitions.pop(undo.hash, plyCount);
+
+	sideToMove = invertColor(sideToMove);
+	enPassantSquare = undo.enPassantSquare;
+	lastIrreversiblePly = undo.lastIrreversiblePly;
+	hashCode = undo.hash;
+}
+
 bool ChessBoard::isDraw() const {
 	// 50 move rule
 	if (halfMoveClock >= 100) return true;
-	// repetition
-	for (int j = positionHistory.size() - 4;
-		 j >= 0 && (irreversibleIndices.empty() || irreversibleIndices.back() < j);
-		 j -= 2) {
-		if (positionHistory[j] == hashCode) {
-			return true;
-		}
-		 }
+	// repetition - a single probe of the incremental table, the side to move
+	// is part of the hash so no parity filtering is needed
+	if (repetitions.contains(hashCode, lastIrreversiblePly)) return true;
 	// insufficient material
-	if (whitePieces.empty() && whitePawns.empty() && blackPieces.empty() && blackPawns.empty()) return true;
+	if (pieceCount[WHITE] == 0 && pawnCount[WHITE] == 0 && pieceCount[BLACK] == 0 && pawnCount[BLACK] == 0) return true;
 
 	return false;
 }
@@ -171,12 +280,21 @@ void ChessBoard::movePiece(int_fast8_t start, int_fast8_t end) {
 	squares[end] = squares[start];
 	squares[start] = {EMPTY, WHITE};
 
+	bitboards[piece.color][piece.type] ^= Bitboards::bit(start) | Bitboards::bit(end);
+	occupancy[piece.color] ^= Bitboards::bit(start) | Bitboards::bit(end);
+
+	const int tableIndex = piece.type - 1;
+	const int_fast8_t tableStart = (piece.color == WHITE) ? start : flipPosition(start);
+	const int_fast8_t tableEnd = (piece.color == WHITE) ? end : flipPosition(end);
+	midgameScore[piece.color] += mg_pesto_table[tableIndex][tableEnd] - mg_pesto_table[tableIndex][tableStart];
+	endgameScore[piece.color] += eg_pesto_table[tableIndex][tableEnd] - eg_pesto_table[tableIndex][tableStart];
+
 	switch (piece.type) {
 		case PAWN: {
-			std::vector<int_fast8_t>* pawnList = (piece.color == WHITE) ? &whitePawns : &blackPawns;
-			for (int_fast8_t&i: *pawnList) {
-				if (i == start) {
-					i = end;
+			int_fast8_t* positions = pawnPositions[piece.color].data();
+			for (int i = 0; i < pawnCount[piece.color]; ++i) {
+				if (positions[i] == start) {
+					positions[i] = end;
 					break;
 				}
 			}
@@ -187,10 +305,10 @@ void ChessBoard::movePiece(int_fast8_t start, int_fast8_t end) {
 			*kingPosition = end;
 		}
 		default: {
-			std::vector<Piece>* pieceList = (piece.color == WHITE) ? &whitePieces : &blackPieces;
-			for (Piece&i: *pieceList) {
-				if (i.position == start) {
-					i.position = end;
+			int_fast8_t* positions = piecePositions[piece.color].data();
+			for (int i = 0; i < pieceCount[piece.color]; ++i) {
+				if (positions[i] == start) {
+					positions[i] = end;
 					break;
 				}
 			}
@@ -200,13 +318,25 @@ void ChessBoard::movePiece(int_fast8_t start, int_fast8_t end) {
 
 	hashCode ^= hashCodes.pieceCode(piece.type, piece.color, start);
 	hashCode ^= hashCodes.pieceCode(piece.type, piece.color, end);
+	if (piece.type == PAWN) {
+		pawnHashCode ^= hashCodes.pieceCode(PAWN, piece.color, start);
+		pawnHashCode ^= hashCodes.pieceCode(PAWN, piece.color, end);
+	}
 }
 
 void ChessBoard::setPiece(int_fast8_t position, const Square&piece) {
+	bitboards[piece.color][piece.type] |= Bitboards::bit(position);
+	occupancy[piece.color] |= Bitboards::bit(position);
+
+	const int tableIndex = piece.type - 1;
+	const int_fast8_t tablePosition = (piece.color == WHITE) ? position : flipPosition(position);
+	midgameScore[piece.color] += mg_value[tableIndex] + mg_pesto_table[tableIndex][tablePosition];
+	endgameScore[piece.color] += eg_value[tableIndex] + eg_pesto_table[tableIndex][tablePosition];
+	gamePhase += gamephaseInc[tableIndex];
+
 	switch (piece.type) {
 		case PAWN: {
-			std::vector<int_fast8_t>* pawnList = (piece.color == WHITE) ? &whitePawns : &blackPawns;
-			pawnList->push_back(position);
+			pawnPositions[piece.color][pawnCount[piece.color]++] = position;
 		}
 		break;
 		case KING: {
@@ -214,39 +344,55 @@ void ChessBoard::setPiece(int_fast8_t position, const Square&piece) {
 			*kingPosition = position;
 		}
 		default: {
-			std::vector<Piece>* pieceList = (piece.color == WHITE) ? &whitePieces : &blackPieces;
-			pieceList->push_back({piece.type, position});
+			const int count = pieceCount[piece.color]++;
+			piecePositions[piece.color][count] = position;
+			pieceTypes[piece.color][count] = piece.type;
 		}
 		break;
 	}
 
 	hashCode ^= hashCodes.pieceCode(piece.type, piece.color, position);
+	if (piece.type == PAWN) pawnHashCode ^= hashCodes.pieceCode(PAWN, piece.color, position);
 	squares[position] = piece;
 }
 
 void ChessBoard::removePiece(int_fast8_t position) {
 	const Square piece = squares[position];
 
+	bitboards[piece.color][piece.type] &= ~Bitboards::bit(position);
+	occupancy[piece.color] &= ~Bitboards::bit(position);
+
+	const int tableIndex = piece.type - 1;
+	const int_fast8_t tablePosition = (piece.color == WHITE) ? position : flipPosition(position);
+	midgameScore[piece.color] -= mg_value[tableIndex] + mg_pesto_table[tableIndex][tablePosition];
+	endgameScore[piece.color] -= eg_value[tableIndex] + eg_pesto_table[tableIndex][tablePosition];
+	gamePhase -= gamephaseInc[tableIndex];
+
 	if (piece.type == PAWN) {
-		std::vector<int_fast8_t>* pawnList = (piece.color == WHITE) ? &whitePawns : &blackPawns;
-		for (int i = 0; pawnList->size() > i; i++) {
-			if ((*pawnList)[i] == position) {
-				pawnList->erase(pawnList->begin() + i);
+		int_fast8_t* positions = pawnPositions[piece.color].data();
+		const int last = --pawnCount[piece.color];
+		for (int i = 0; i <= last; i++) {
+			if (positions[i] == position) {
+				positions[i] = positions[last];
 				break;
 			}
 		}
 	}
 	else {
-		std::vector<Piece>* pieceList = (piece.color == WHITE) ? &whitePieces : &blackPieces;
-		for (int i = 0; pieceList->size() > i; i++) {
-			if ((*pieceList)[i].position == position) {
-				pieceList->erase(pieceList->begin() + i);
+		int_fast8_t* positions = piecePositions[piece.color].data();
+		Type* types = pieceTypes[piece.color].data();
+		const int last = --pieceCount[piece.color];
+		for (int i = 0; i <= last; i++) {
+			if (positions[i] == position) {
+				positions[i] = positions[last];
+				types[i] = types[last];
 				break;
 			}
 		}
 	}
 
 	hashCode ^= hashCodes.pieceCode(piece.type, piece.color, position);
+	if (piece.type == PAWN) pawnHashCode ^= hashCodes.pieceCode(PAWN, piece.color, position);
 	squares[position] = {EMPTY, WHITE};
 }
 
@@ -340,19 +486,24 @@ std::string ChessBoard::fen() const {
 
 void ChessBoard::setPosition(const std::string&fen) {
 	hashCode = hashCodes.initialCode;
+	pawnHashCode = 0;
 	int_fast8_t position = 0;
 	int index = 0;
 
-	whitePieces = std::vector<Piece>();
-	blackPieces = std::vector<Piece>();
-	whitePawns = std::vector<int_fast8_t>();
-	blackPawns = std::vector<int_fast8_t>();
+	pieceCount = std::array<int, 2>();
+	pawnCount = std::array<int, 2>();
 	whiteKing = -1;
 	blackKing = -1;
 	squares = std::array<Square, 64>();
+	bitboards = std::array<std::array<uint64_t, 7>, 2>();
+	occupancy = std::array<uint64_t, 2>();
+	midgameScore = std::array<int, 2>();
+	endgameScore = std::array<int, 2>();
+	gamePhase = 0;
 	enPassantSquare = -1;
-	positionHistory = std::vector<uint64_t>();
-	irreversibleIndices = std::vector<int>();
+	plyCount = 0;
+	lastIrreversiblePly = -1;
+	repetitions.clear();
 
 	while (fen[index] != ' ') {
 		if (fen[index] == '/') {
@@ -432,5 +583,6 @@ void ChessBoard::setPosition(const std::string&fen) {
 }
 
 ChessBoard::ChessBoard() {
+	Bitboards::init();
 	hashCodes.initialize();
 }
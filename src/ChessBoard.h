@@ -4,6 +4,7 @@
 
 #include <vector>
 #include <cstdint>
+#include "Bitboards.h"
 #include "Move.h"
 #include "Piece.h"
 #include "HashCodes.h"
@@ -31,11 +32,29 @@ public:
 
     std::array<Square, 64> squares{};
 
-    std::vector<Piece> whitePieces;
-    std::vector<Piece> blackPieces;
-
-    std::vector<int_fast8_t> whitePawns;
-    std::vector<int_fast8_t> blackPawns;
+    // per-color, per-type occupancy masks, kept in sync with the mailbox by
+    // setPiece/removePiece/movePiece (type index 0 is unused)
+    std::array<std::array<uint64_t, 7>, 2> bitboards{};
+    std::array<uint64_t, 2> occupancy{};
+
+    // incremental PeSTO accumulators (material + piece-square sums per side),
+    // maintained by the same three methods so evaluation is a constant-time blend
+    std::array<int, 2> midgameScore{};
+    std::array<int, 2> endgameScore{};
+    int gamePhase = 0;
+
+    // piece lists in structure-of-arrays form: positions in one contiguous
+    // array per side, types in a parallel one (kings included, pawns kept
+    // separately as bare positions). Scans are branch-light linear passes
+    // over small arrays, and removal swaps with the last element instead of
+    // shifting a vector tail
+    static constexpr int MAX_PIECES = 16;
+    std::array<std::array<int_fast8_t, MAX_PIECES>, 2> piecePositions{};
+    std::array<std::array<Type, MAX_PIECES>, 2> pieceTypes{};
+    std::array<int, 2> pieceCount{};
+
+    std::array<std::array<int_fast8_t, 8>, 2> pawnPositions{};
+    std::array<int, 2> pawnCount{};
 
     int_fast8_t whiteKing{};
     int_fast8_t blackKing{};
@@ -47,15 +66,70 @@ public:
     int halfMoveClock = 0;
     int fullMoveClock = 1;
 
-    std::vector<Move> moveHistory;
-    std::vector<CastlingRights> castlingRightHistory;
-    std::vector<int_fast8_t> enPassantHistory;
-    std::vector<int> halfMoveClockHistory;
+    // everything makeMove needs saved to take a move back, packed into one
+    // record per ply so make/unmake touches a single preallocated array
+    struct UndoInfo {
+        Move move;
+        uint64_t hash; //position hash before the move
+        CastlingRights castlingRights;
+        int_fast8_t enPassantSquare;
+        int halfMoveClock;
+        int lastIrreversiblePly; //value before the move, restored on unmake
+    };
+
+    static constexpr int MAX_GAME_LENGTH = 1024;
+
+    std::array<UndoInfo, MAX_GAME_LENGTH> undoStack;
+    int plyCount = 0;
+    int lastIrreversiblePly = -1; //undo stack index of the latest irreversible move
+
+    // open-addressed hash of every position on the undo stack, so repetition
+    // detection is a constant-time probe instead of a scan back to the last
+    // irreversible move. Make/unmake nest strictly, so the entry removed is
+    // always the newest one and emptying its slot never breaks the probe
+    // chain of an older entry
+    struct RepetitionTable {
+        static constexpr int SIZE = MAX_GAME_LENGTH * 2; //keeps the load factor below one half
+        static constexpr uint64_t MASK = SIZE - 1;
+
+        std::array<uint64_t, SIZE> hashes{};
+        std::array<int, SIZE> plies{};
+
+        RepetitionTable() { plies.fill(-1); }
+
+        void push(const uint64_t hash, const int ply) {
+            uint64_t slot = hash & MASK;
+            while (plies[slot] != -1) slot = (slot + 1) & MASK;
+            hashes[slot] = hash;
+            plies[slot] = ply;
+        }
+
+        void pop(const uint64_t hash, const int ply) {
+            uint64_t slot = hash & MASK;
+            while (hashes[slot] != hash || plies[slot] != ply) slot = (slot + 1) & MASK;
+            plies[slot] = -1;
+        }
+
+        // has this position occurred since the last irreversible move? Stale
+        // entries from before it stay in the table and are filtered by ply,
+        // which keeps irreversible moves from paying for a full clear
+        bool contains(const uint64_t hash, const int lastIrreversiblePly) const {
+            for (uint64_t slot = hash & MASK; plies[slot] != -1; slot = (slot + 1) & MASK) {
+                if (hashes[slot] == hash && plies[slot] > lastIrreversiblePly) return true;
+            }
+            return false;
+        }
+
+        void clear() { plies.fill(-1); }
+    };
 
-    std::vector<uint64_t> positionHistory;
-    std::vector<int> irreversibleIndices; //indices of positionHistory from where irreversible moves were made
+    RepetitionTable repetitions{};
 
     uint64_t hashCode{};
+    // pawns-only key for the pawn structure hash table, maintained from the
+    // same piece codes as hashCode - pure piece XORs, so make/unmake restores
+    // it without undo bookkeeping
+    uint64_t pawnHashCode{};
     HashCodes hashCodes{};
 
     ChessBoard();
@@ -68,12 +142,31 @@ public:
 
     std::string fen() const;
 
+    // inflates a stored 16-bit move back to the full representation using the
+    // current position; NULL_PACKED_MOVE expands to NULL_MOVE. The result of
+    // expanding a stale entry is rejected by the usual pseudo-legality checks
+    Move expandMove(PackedMove move) const;
+
     void makeMove(const Move &move);
 
     void unMakeMove();
 
+    void makeNullMove();
+
+    void unMakeNullMove();
+
     bool isDraw() const;
 
+    uint64_t occupied() const { return occupancy[WHITE] | occupancy[BLACK]; }
+
+    uint64_t pieces(const Color color, const Type type) const { return bitboards[color][type]; }
+
+    uint64_t attackersTo(int_fast8_t square, uint64_t occupied) const;
+
+    // static exchange evaluation: resolves the full capture sequence on the
+    // target square, positive means the move wins material
+    int see(const Move &move) const;
+
 private:
     void movePiece(int_fast8_t start, int_fast8_t end);
 
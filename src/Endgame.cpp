@@ -0,0 +1,213 @@
+#include "Endgame.h"
+
+#include <algorithm>
+#include <climits>
+
+#include "Bitboards.h"
+
+using namespace Pieces;
+
+std::array<std::vector<uint8_t>, 3> &Endgame::tables = *new std::array<std::vector<uint8_t>, 3>{};
+std::atomic<bool> Endgame::ready = false;
+std::atomic<bool> Endgame::enabled = true;
+
+void Endgame::init() {
+    static std::atomic<bool> started = false;
+    if (started.exchange(true)) return;
+
+    Bitboards::init();
+    generate(QUEEN, tables[TB_QUEEN], nullptr);
+    generate(ROOK, tables[TB_ROOK], nullptr);
+    // pawn promotions convert into the queen table, so it must exist first
+    generate(PAWN, tables[TB_PAWN], &tables[TB_QUEEN]);
+    ready.store(true, std::memory_order_release);
+}
+
+bool Endgame::probe(const ChessBoard &board, int &score) {
+    if (!enabled.load(std::memory_order_relaxed) || !ready.load(std::memory_order_acquire)) return false;
+
+    const int men = board.pieceCount[WHITE] + board.pieceCount[BLACK] +
+                    board.pawnCount[WHITE] + board.pawnCount[BLACK];
+    if (men > 3) return false;
+    if (men == 2) {
+        score = 0;
+        return true;
+    }
+
+    // locate the single non-king man and the side owning it
+    Color strong;
+    Type piece;
+    int_fast8_t square;
+    if (board.pawnCount[WHITE] == 1) {
+        strong = WHITE;
+        piece = PAWN;
+        square = board.pawnPositions[WHITE][0];
+    } else if (board.pawnCount[BLACK] == 1) {
+        strong = BLACK;
+        piece = PAWN;
+        square = board.pawnPositions[BLACK][0];
+    } else {
+        strong = board.pieceCount[WHITE] == 2 ? WHITE : BLACK;
+        const int slot = board.pieceTypes[strong][0] == KING ? 1 : 0;
+        piece = board.pieceTypes[strong][slot];
+        square = board.piecePositions[strong][slot];
+    }
+
+    // a lone minor piece cannot mate no matter what either side plays
+    if (piece == KNIGHT || piece == BISHOP) {
+        score = 0;
+        return true;
+    }
+
+    // the tables store white as the strong side, mirror vertically when the
+    // strong side is black
+    int strongKing = board.whiteKing, weakKing = board.blackKing, pieceSquare = square;
+    if (strong == BLACK) {
+        strongKing = board.blackKing ^ 56;
+        weakKing = board.whiteKing ^ 56;
+        pieceSquare = square ^ 56;
+    }
+    const int strongToMove = board.sideToMove == strong ? 0 : 1;
+
+    const std::vector<uint8_t> &table = tables[piece == QUEEN ? TB_QUEEN : piece == ROOK ? TB_ROOK : TB_PAWN];
+    const uint8_t distance = table[index(strongToMove, strongKing, weakKing, pieceSquare)];
+    if (distance >= DRAWN) {
+        score = 0;
+        return true;
+    }
+    // a win the 50-move rule would void is left to the search
+    if (board.halfMoveClock + distance >= 100) return false;
+    score = strongToMove == 0 ? WIN_SCORE - distance : -(WIN_SCORE - distance);
+    return true;
+}
+
+void Endgame::generate(const Type piece, std::vector<uint8_t> &dtm, const std::vector<uint8_t> *queenTable) {
+    dtm.assign(TABLE_SIZE, UNDECIDED);
+
+    const auto pieceAttacks = [piece](const int_fast8_t square, const uint64_t occupied) {
+        if (piece == PAWN) return Bitboards::pawnAttacks(WHITE, square);
+        return Bitboards::attacks(piece, occupied, square);
+    };
+
+    // states are (side to move, white king, black king, piece square) with
+    // white as the strong side; illegal arrangements stay UNDECIDED and are
+    // never probed
+    const auto legal = [&](const int strongToMove, const int wk, const int bk, const int p) {
+        if (wk == bk || wk == p || bk == p) return false;
+        if (Bitboards::kingAttacks(wk) & Bitboards::bit(bk)) return false;
+        if (piece == PAWN && (p < 8 || p > 55)) return false;
+        // black in check with white to move means the king could be captured
+        if (strongToMove == 0 &&
+            (pieceAttacks(p, Bitboards::bit(wk) | Bitboards::bit(bk) | Bitboards::bit(p)) & Bitboards::bit(bk)))
+            return false;
+        return true;
+    };
+
+    // visits the table value after every legal black reply, returns false
+    // when there is none (mate or stalemate). Capturing the piece is only
+    // reachable when the white king does not defend it - the defended square
+    // is masked out with the rest of his attacks - and leaves a bare-kings
+    // draw
+    const auto forEachBlackMove = [&](const int wk, const int bk, const int p, auto &&visit) {
+        bool any = false;
+        const uint64_t occupiedNoKing = Bitboards::bit(wk) | Bitboards::bit(p);
+        uint64_t targets = Bitboards::kingAttacks(bk) & ~Bitboards::kingAttacks(wk);
+        while (targets) {
+            const int_fast8_t to = Bitboards::popLsb(targets);
+            if (to == p) {
+                any = true;
+                visit(DRAWN);
+                continue;
+            }
+            // the vacated king square must not reopen a slider ray onto the
+            // destination, so the attack set is computed without the king
+            if (pieceAttacks(p, occupiedNoKing) & Bitboards::bit(to)) continue;
+            any = true;
+            visit(dtm[index(0, wk, to, p)]);
+        }
+        return any;
+    };
+
+    // shortest win over every legal white move, INT_MAX when none is proven
+    // yet. Pushes convert into the queen table on the promotion rank
+    const auto bestWhiteMove = [&](const int wk, const int bk, const int p) {
+        int best = INT_MAX;
+        uint64_t kingTargets = Bitboards::kingAttacks(wk) & ~Bitboards::kingAttacks(bk) & ~Bitboards::bit(p);
+        while (kingTargets) {
+            const int_fast8_t to = Bitboards::popLsb(kingTargets);
+            const uint8_t value = dtm[index(1, to, bk, p)];
+            if (value < DRAWN) best = std::min(best, value + 1);
+        }
+        if (piece == PAWN) {
+            const int push = p - 8;
+            if (push != wk && push != bk) {
+                if (push < 8) {
+                    const uint8_t value = (*queenTable)[index(1, wk, bk, push)];
+                    if (value < DRAWN) best = std::min(best, value + 1);
+                } else {
+                    const uint8_t value = dtm[index(1, wk, bk, push)];
+                    if (value < DRAWN) best = std::min(best, value + 1);
+                    if (p >= 48 && p - 16 != wk && p - 16 != bk) {
+                        const uint8_t doublePush = dtm[index(1, wk, bk, p - 16)];
+                        if (doublePush < DRAWN) best = std::min(best, doublePush + 1);
+                    }
+                }
+            }
+        } else {
+            const uint64_t occupied = Bitboards::bit(wk) | Bitboards::bit(bk) | Bitboards::bit(p);
+            uint64_t targets = pieceAttacks(p, occupied) & ~Bitboards::bit(wk);
+            while (targets) {
+                const int_fast8_t to = Bitboards::popLsb(targets);
+                const uint8_t value = dtm[index(1, wk, bk, to)];
+                if (value < DRAWN) best = std::min(best, value + 1);
+            }
+        }
+        return best;
+    };
+
+    // seed the black-to-move terminals: checkmate is a loss in zero plies,
+    // stalemate a decided draw
+    for (int wk = 0; wk < 64; ++wk)
+        for (int bk = 0; bk < 64; ++bk)
+            for (int p = 0; p < 64; ++p) {
+                if (!legal(1, wk, bk, p)) continue;
+                if (forEachBlackMove(wk, bk, p, [](uint8_t) {})) continue;
+                const uint64_t occupied = Bitboards::bit(wk) | Bitboards::bit(bk) | Bitboards::bit(p);
+                const bool inCheck = pieceAttacks(p, occupied) & Bitboards::bit(bk);
+                dtm[index(1, wk, bk, p)] = inCheck ? 0 : DRAWN;
+            }
+
+    // value iteration to the fixpoint: white states take the quickest proven
+    // win plus one ply, black states are lost only once every reply lands in
+    // a won white state, and then the defence maximizes the distance. Values
+    // only ever shrink, so the sweeps terminate at the exact distances
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (int wk = 0; wk < 64; ++wk)
+            for (int bk = 0; bk < 64; ++bk)
+                for (int p = 0; p < 64; ++p) {
+                    if (legal(0, wk, bk, p)) {
+                        const int i = index(0, wk, bk, p);
+                        const int best = bestWhiteMove(wk, bk, p);
+                        if (best < dtm[i]) {
+                            dtm[i] = best;
+                            changed = true;
+                        }
+                    }
+                    if (legal(1, wk, bk, p)) {
+                        const int i = index(1, wk, bk, p);
+                        int worst = -1;
+                        bool allLost = true;
+                        forEachBlackMove(wk, bk, p, [&](const uint8_t value) {
+                            if (value < DRAWN) worst = std::max(worst, (int) value);
+                            else allLost = false;
+                        });
+                        if (allLost && worst >= 0 && worst + 1 < dtm[i]) {
+                            dtm[i] = worst + 1;
+                            changed = true;
+                        }
+                    }
+                }
+    }
+}
@@ -0,0 +1,51 @@
+#ifndef CHESSENGINE_ENDGAME_H
+#define CHESSENGINE_ENDGAME_H
+
+#include <atomic>
+#include "ChessBoard.h"
+
+// Built-in three-man endgame tablebases. KQvK, KRvK and KPvK are solved by
+// retrograde value iteration into distance-to-mate tables (about half a
+// megabyte each), KBvK and KNvK are dead draws and KvK trivially so, which
+// covers every possible three-man position. The tables are generated once on
+// a background thread at startup; until they are ready probes simply miss.
+class Endgame {
+public:
+    // exact scores sit in their own band: far above any evaluation, below
+    // the mate band, and graded by distance to mate so the search converts
+    // instead of shuffling
+    static constexpr int WIN_SCORE = 1 << 20;
+
+    // generates the tables on a detached thread, first call only
+    static void init();
+
+    // can be switched off with "setoption name Tablebase value false"
+    static std::atomic<bool> enabled;
+
+    // exact score for the side to move when the position is covered (three
+    // men or fewer and the 50-move counter cannot void the win); false when
+    // not covered or the tables are still generating
+    static bool probe(const ChessBoard &board, int &score);
+
+private:
+    enum Material { TB_QUEEN = 0, TB_ROOK = 1, TB_PAWN = 2 };
+
+    // plies to mate for the strong side, indexed by (side to move, strong
+    // king, weak king, piece square); DRAWN and UNDECIDED both mean draw
+    static constexpr uint8_t DRAWN = 0xFE;
+    static constexpr uint8_t UNDECIDED = 0xFF;
+    static constexpr int TABLE_SIZE = 2 * 64 * 64 * 64;
+
+    // heap-allocated and deliberately leaked: quitting while the generator
+    // thread is still running must not tear the tables down under it
+    static std::array<std::vector<uint8_t>, 3> &tables;
+    static std::atomic<bool> ready;
+
+    static int index(const int strongToMove, const int strongKing, const int weakKing, const int pieceSquare) {
+        return ((strongToMove * 64 + strongKing) * 64 + weakKing) * 64 + pieceSquare;
+    }
+
+    static void generate(Pieces::Type piece, std::vector<uint8_t> &dtm, const std::vector<uint8_t> *queenTable);
+};
+
+#endif //CHESSENGINE_ENDGAME_H
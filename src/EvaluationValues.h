@@ -2,8 +2,28 @@
 #define CHESSENGINE_EVALUATIONVALUES_H
 
 #include <array>
+#include <cstdint>
 
 namespace EvaluationValues {
+	// mirrors a square index to the other side's point of view for the tables
+	inline int_fast8_t flipPosition(const int_fast8_t pos) {
+		const int_fast8_t file = pos % 8;
+		const int_fast8_t rank = pos / 8;
+
+		return (7 - rank) * 8 + file;
+	}
+
+	// pawn structure terms on the same scale as the piece values, applied per
+	// pawn from white's point of view
+	constexpr int mg_doubled_pawn = -110;
+	constexpr int eg_doubled_pawn = -280;
+	constexpr int mg_isolated_pawn = -170;
+	constexpr int eg_isolated_pawn = -120;
+	// indexed by how far the passed pawn has advanced (1 = still on its
+	// starting rank, 6 = one step from promotion)
+	constexpr std::array<int, 8> mg_passed_pawn = {0, 50, 100, 170, 290, 560, 1020, 0};
+	constexpr std::array<int, 8> eg_passed_pawn = {0, 130, 180, 290, 480, 840, 1380, 0};
+
 	const std::array<int, 6> mg_value = {820, 3370, 3650, 4770, 10250, 0};
 	const std::array<int, 6> eg_value = {940, 2810, 2970, 5120, 9360, 0};
 	const std::array<int, 6> gamephaseInc = {0, 10, 10, 20, 40, 0};
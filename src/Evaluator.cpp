@@ -1,50 +1,125 @@
 #include "Evaluator.h"
 
-int Evaluator::evaluate(const ChessBoard &board) {
+#include <atomic>
+#include <bit>
+
+#include "Bitboards.h"
+
+namespace {
+    // pawn structure cache, keyed on ChessBoard::pawnHashCode. Same key XOR
+    // data scheme as the transposition table, so the helper threads can share
+    // it without locks - a torn entry just fails the key check.
+    struct PawnEntry {
+        std::atomic<uint64_t> keyXorData;
+        std::atomic<uint64_t> data;
+    };
+
+    constexpr size_t PAWN_TABLE_SIZE = 1 << 16;
+    std::array<PawnEntry, PAWN_TABLE_SIZE> pawnTable;
 
-    int gamePhase = 0;
-    int whiteTableMidScore = 0;
-    int whiteTableEndScore = 0;
-    int blackTableMidScore = 0;
-    int blackTableEndScore = 0;
-
-    for (const Piece &piece: board.whitePieces) {
-        const int index = piece.type - 1;
-        whiteTableMidScore += mg_value[index] + mg_pesto_table[index][piece.position];
-        whiteTableEndScore += eg_value[index] + eg_pesto_table[index][piece.position];
-        gamePhase += gamephaseInc[index];
+    constexpr uint64_t FILE_A = 0x0101010101010101ULL;
+
+    uint64_t packPawnScore(const int mg, const int eg) {
+        return (static_cast<uint64_t>(static_cast<uint32_t>(mg)) << 32) | static_cast<uint32_t>(eg);
     }
-    for (const int_fast8_t &pos: board.whitePawns) {
-        whiteTableMidScore += mg_value[0] + mg_pesto_table[0][pos];
-        whiteTableEndScore += eg_value[0] + eg_pesto_table[0][pos];
+
+    // doubled, isolated and passed pawns for both colors, white minus black
+    void evaluatePawnStructure(const uint64_t whitePawns, const uint64_t blackPawns, int &mg, int &eg) {
+        const Evaluator::PawnFeatures features = Evaluator::pawnFeatures(whitePawns, blackPawns);
+
+        mg = features.doubled * mg_doubled_pawn + features.isolated * mg_isolated_pawn;
+        eg = features.doubled * eg_doubled_pawn + features.isolated * eg_isolated_pawn;
+        for (int i = 0; i < 8; ++i) {
+            mg += features.passed[i] * mg_passed_pawn[i];
+            eg += features.passed[i] * eg_passed_pawn[i];
+        }
     }
-    for (const Piece &piece: board.blackPieces) {
-        const int index = piece.type - 1;
-        const int_fast8_t position = flipPosition(piece.position);
-        blackTableMidScore += mg_value[index] + mg_pesto_table[index][position];
-        blackTableEndScore += eg_value[index] + eg_pesto_table[index][position];
-        gamePhase += gamephaseInc[index];
+
+    // computed once per unique pawn formation, a probe everywhere else
+    void pawnStructureScore(const ChessBoard &board, int &mg, int &eg) {
+        const uint64_t key = board.pawnHashCode;
+        PawnEntry &entry = pawnTable[key & (PAWN_TABLE_SIZE - 1)];
+
+        const uint64_t data = entry.data.load(std::memory_order_relaxed);
+        if ((entry.keyXorData.load(std::memory_order_relaxed) ^ data) == key) {
+            mg = static_cast<int32_t>(data >> 32);
+            eg = static_cast<int32_t>(data & 0xffffffff);
+            return;
+        }
+
+        evaluatePawnStructure(board.pieces(WHITE, PAWN), board.pieces(BLACK, PAWN), mg, eg);
+
+        const uint64_t packed = packPawnScore(mg, eg);
+        entry.data.store(packed, std::memory_order_relaxed);
+        entry.keyXorData.store(key ^ packed, std::memory_order_relaxed);
     }
-    for (const int_fast8_t &pos: board.blackPawns) {
-        const int_fast8_t position = flipPosition(pos);
-        blackTableMidScore += mg_value[0] + mg_pesto_table[0][position];
-        blackTableEndScore += eg_value[0] + eg_pesto_table[0][position];
+}
+
+Evaluator::PawnFeatures Evaluator::pawnFeatures(const uint64_t whitePawns, const uint64_t blackPawns) {
+    PawnFeatures features{};
+
+    for (int file = 0; file < 8; ++file) {
+        const uint64_t fileMask = FILE_A << file;
+        const uint64_t neighbourMask = ((file > 0) ? FILE_A << (file - 1) : 0)
+                                       | ((file < 7) ? FILE_A << (file + 1) : 0);
+
+        const int whiteOnFile = std::popcount(whitePawns & fileMask);
+        const int blackOnFile = std::popcount(blackPawns & fileMask);
+        if (whiteOnFile > 1) features.doubled += whiteOnFile - 1;
+        if (blackOnFile > 1) features.doubled -= blackOnFile - 1;
+
+        if (whiteOnFile > 0 && !(whitePawns & neighbourMask)) features.isolated += whiteOnFile;
+        if (blackOnFile > 0 && !(blackPawns & neighbourMask)) features.isolated -= blackOnFile;
     }
 
-    const int midGameScore = (board.sideToMove == WHITE) ? whiteTableMidScore - blackTableMidScore : blackTableMidScore -
-                                                                                                     whiteTableMidScore;
-    const int endGameScore = (board.sideToMove == WHITE) ? whiteTableEndScore - blackTableEndScore : blackTableEndScore -
-                                                                                                     whiteTableEndScore;
+    uint64_t pawns = whitePawns;
+    while (pawns) {
+        const int_fast8_t square = Bitboards::popLsb(pawns);
+        const int rank = square / 8;
+        const int file = square % 8;
+        const uint64_t span = (FILE_A << file
+                               | ((file > 0) ? FILE_A << (file - 1) : 0)
+                               | ((file < 7) ? FILE_A << (file + 1) : 0))
+                              // white promotes towards lower indices
+                              & ((1ULL << (rank * 8)) - 1);
+        if (!(blackPawns & span)) features.passed[7 - rank]++;
+    }
 
-    const int midGamePhase = (gamePhase > 24) ? 24 : gamePhase;
-    const int endGamePhase = 24 - midGamePhase;
+    pawns = blackPawns;
+    while (pawns) {
+        const int_fast8_t square = Bitboards::popLsb(pawns);
+        const int rank = square / 8;
+        const int file = square % 8;
+        const uint64_t span = (FILE_A << file
+                               | ((file > 0) ? FILE_A << (file - 1) : 0)
+                               | ((file < 7) ? FILE_A << (file + 1) : 0))
+                              & ~((1ULL << ((rank + 1) * 8)) - 1);
+        if (!(whitePawns & span)) features.passed[rank]--;
+    }
 
-    return ((midGameScore * midGamePhase + endGameScore * endGamePhase) / 24) + Util::randomOffset();
+    return features;
 }
 
-int_fast8_t Evaluator::flipPosition(const int_fast8_t pos) {
-    const int_fast8_t file = pos % 8;
-    const int_fast8_t rank = pos / 8;
+int Evaluator::evaluate(const ChessBoard &board) {
 
-    return (7 - rank) * 8 + file;
+    int midGameScore = (board.sideToMove == WHITE)
+                                 ? board.midgameScore[WHITE] - board.midgameScore[BLACK]
+                                 : board.midgameScore[BLACK] - board.midgameScore[WHITE];
+    int endGameScore = (board.sideToMove == WHITE)
+                                 ? board.endgameScore[WHITE] - board.endgameScore[BLACK]
+                                 : board.endgameScore[BLACK] - board.endgameScore[WHITE];
+
+    int pawnMidGame, pawnEndGame;
+    pawnStructureScore(board, pawnMidGame, pawnEndGame);
+    if (board.sideToMove == BLACK) {
+        pawnMidGame = -pawnMidGame;
+        pawnEndGame = -pawnEndGame;
+    }
+    midGameScore += pawnMidGame;
+    endGameScore += pawnEndGame;
+
+    const int midGamePhase = (board.gamePhase > 24) ? 24 : board.gamePhase;
+    const int endGamePhase = 24 - midGamePhase;
+
+    return ((midGameScore * midGamePhase + endGameScore * endGamePhase) / 24) + Util::randomOffset();
 }
@@ -9,10 +9,17 @@ using namespace EvaluationValues;
 class Evaluator {
 
 public:
-    static int evaluate(const ChessBoard &board);
+    // white-minus-black pawn structure feature counts. The weighted sum of
+    // these is the pawn structure score, and the offline tuner reuses the
+    // same counts so its model cannot drift from the search evaluation
+    struct PawnFeatures {
+        int doubled;
+        int isolated;
+        std::array<int, 8> passed; //indexed like the passed pawn tables
+    };
 
+    static PawnFeatures pawnFeatures(uint64_t whitePawns, uint64_t blackPawns);
 
-private:
-    static int_fast8_t flipPosition(int_fast8_t pos);
+    static int evaluate(const ChessBoard &board);
 };
 #endif //CHESSENGINE_EVALUATOR_H
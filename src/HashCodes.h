@@ -14,8 +14,10 @@ public:
     std::array<uint64_t, 8> enPassantFileCode;
 
     void initialize() {
-        std::random_device dev;
-        std::mt19937_64 rng(dev());
+        // fixed seed: the codes have to be identical across runs (and between
+        // boards) so persistent data like the binary opening book can be
+        // keyed by position hash
+        std::mt19937_64 rng(0x9ff32186c7a2b1e5ULL);
         std::uniform_int_distribution dist(std::numeric_limits<uint64_t>::min(), std::numeric_limits<uint64_t>::max());
 
         initialCode = dist(rng);
@@ -1,5 +1,6 @@
 #include "Logger.h"
 
+#include <chrono>
 #include <iostream>
 
 #ifdef wasm
@@ -16,6 +17,11 @@ void Logger::start() {
 #ifdef logtofile
     logFile.open("log.txt");
 #endif
+#ifdef searchtrace
+    traceWriteIndex = 0;
+    traceReadIndex = 0;
+    traceFile.open("trace.bin", std::ios::binary);
+#endif
 }
 
 void Logger::end() {
@@ -29,6 +35,21 @@ void Logger::end() {
 #ifdef logtofile
     logFile.close();
 #endif
+#ifdef searchtrace
+    traceFile.close();
+#endif
+}
+
+// never blocks and never allocates: a full ring drops the record, the
+// background thread picks the rest up on its next pass
+void Logger::trace(const TraceEvent event, const int8_t depth, const uint8_t ply, const int8_t start,
+                   const int8_t end, const int32_t score) const {
+#ifdef searchtrace
+    const uint64_t write = traceWriteIndex.load(std::memory_order_relaxed);
+    if (write - traceReadIndex.load(std::memory_order_acquire) >= TRACE_CAPACITY) return;
+    traceBuffer[write & (TRACE_CAPACITY - 1)] = {score, depth, ply, start, end, event};
+    traceWriteIndex.store(write + 1, std::memory_order_release);
+#endif
 }
 
 void Logger::log(const std::string &message) const {
@@ -107,17 +128,44 @@ Logger::~Logger() {
 
 void Logger::threadFunc() {
     while (!stop) {
-        if (!processNode()) {
+        bool didWork = processNode();
+#ifdef searchtrace
+        didWork |= drainTrace();
+#endif
+        if (!didWork) {
             std::unique_lock lk(m);
             empty = true;
+#ifdef searchtrace
+            // the trace producer never notifies, so poll instead of sleeping
+            cv.wait_for(lk, std::chrono::milliseconds(10), [this] { return !empty || stop; });
+#else
             cv.wait(lk, [this] { return !empty || stop; });
+#endif
             lk.unlock();
         }
     }
-    // Empty the buffer
+    // Empty the buffers
     while (processNode()) {
     }
+#ifdef searchtrace
+    while (drainTrace()) {
+    }
+#endif
+}
+
+#ifdef searchtrace
+bool Logger::drainTrace() {
+    const uint64_t read = traceReadIndex.load(std::memory_order_relaxed);
+    const uint64_t write = traceWriteIndex.load(std::memory_order_acquire);
+    if (read == write) return false;
+    for (uint64_t i = read; i < write; ++i) {
+        traceFile.write(reinterpret_cast<const char *>(&traceBuffer[i & (TRACE_CAPACITY - 1)]),
+                        sizeof(TraceRecord));
+    }
+    traceReadIndex.store(write, std::memory_order_release);
+    return true;
 }
+#endif
 
 bool Logger::processNode() {
     if (head->next != nullptr) {
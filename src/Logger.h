@@ -1,6 +1,9 @@
 #ifndef LOGGER_H
 #define LOGGER_H
+#include <array>
+#include <atomic>
 #include <condition_variable>
+#include <cstdint>
 #include <string>
 #include <thread>
 #include <fstream>
@@ -13,6 +16,35 @@ enum MessageType {
 	TOFILE = 3
 };
 
+enum TraceEvent : uint8_t {
+	TRACE_MOVE_BEGIN = 0,
+	TRACE_MOVE_END = 1,
+	TRACE_TRANSPOSITION = 2,
+	TRACE_BETA_CUTOFF = 3,
+	TRACE_NULL_CUTOFF = 4,
+	TRACE_DRAW = 5,
+	TRACE_BEST_MOVE = 6
+};
+
+// fixed-size binary record for the search trace ring buffer
+struct TraceRecord {
+	int32_t score;
+	int8_t depth;
+	uint8_t ply;
+	int8_t start;
+	int8_t end;
+	uint8_t event;
+};
+
+// The search trace is opt-in at compile time: without the flag the macro
+// expands to nothing, so alphaBeta/quiesce contain no logging code at all.
+#ifdef searchtrace
+#define SEARCH_TRACE(logger, traceEvent, traceDepth, tracePly, traceStart, traceEnd, traceScore) \
+	(logger).trace(traceEvent, traceDepth, tracePly, traceStart, traceEnd, traceScore)
+#else
+#define SEARCH_TRACE(logger, traceEvent, traceDepth, tracePly, traceStart, traceEnd, traceScore) ((void)0)
+#endif
+
 struct Node {
 	Node* next;
 	MessageType type;
@@ -46,6 +78,8 @@ public:
 
 	void sendString(const std::string& name, const std::string& value) const;
 
+	void trace(TraceEvent event, int8_t depth, uint8_t ply, int8_t start, int8_t end, int32_t score) const;
+
 	Logger();
 
 	~Logger();
@@ -55,6 +89,19 @@ private:
 	mutable Node* tail;
 	std::ofstream logFile;
 
+#ifdef searchtrace
+	// single-producer single-consumer ring of trace records: the search
+	// thread publishes with a relaxed store, the logger thread drains to
+	// disk, and records are dropped rather than ever blocking the search
+	static constexpr size_t TRACE_CAPACITY = 1 << 16;
+	mutable std::array<TraceRecord, TRACE_CAPACITY> traceBuffer{};
+	mutable std::atomic<uint64_t> traceWriteIndex{0};
+	mutable std::atomic<uint64_t> traceReadIndex{0};
+	std::ofstream traceFile;
+
+	bool drainTrace();
+#endif
+
 	void threadFunc();
 
 	bool processNode();
@@ -1,6 +1,7 @@
 #ifndef CHESSENGINE_MOVE_H
 #define CHESSENGINE_MOVE_H
 
+#include <array>
 #include <cstdint>
 #include <format>
 #include <iostream>
@@ -52,6 +53,78 @@ namespace Moves {
         return os;
     }
 
+    // 16-bit move for the storage tables: from(6) | to(6) | kind(2) |
+    // promotion piece(2). The player, the captured piece, double pushes and
+    // the castle side are rederived from the position when the move is
+    // expanded back (ChessBoard::expandMove), so transposition, killer and
+    // countermove entries only pay two bytes per move
+    struct PackedMove {
+        enum Kind { NORMAL = 0, PROMOTION = 1, EP = 2, CASTLE = 3 };
+
+        uint16_t bits = 0;
+
+        PackedMove() = default;
+
+        explicit constexpr PackedMove(const uint16_t bits) : bits(bits) {}
+
+        static PackedMove pack(const Move &move) {
+            uint16_t kind = NORMAL;
+            uint16_t promotion = 0;
+            if (move.promotionType != Pieces::EMPTY) {
+                kind = PROMOTION;
+                promotion = move.promotionType - Pieces::KNIGHT;
+            } else if (move.flag == ENPASSANT) kind = EP;
+            else if (move.flag >= CASTLEKINGSIDE) kind = CASTLE;
+            return PackedMove(static_cast<uint16_t>((move.start & 0x3F) | ((move.end & 0x3F) << 6) |
+                                                    (kind << 12) | (promotion << 14)));
+        }
+
+        int_fast8_t start() const { return static_cast<int_fast8_t>(bits & 0x3F); }
+
+        int_fast8_t end() const { return static_cast<int_fast8_t>((bits >> 6) & 0x3F); }
+
+        Kind kind() const { return static_cast<Kind>((bits >> 12) & 0x3); }
+
+        Type promotionType() const {
+            return kind() == PROMOTION ? static_cast<Type>(Pieces::KNIGHT + ((bits >> 14) & 0x3)) : Pieces::EMPTY;
+        }
+
+        bool operator==(const PackedMove &other) const = default;
+
+        std::string toString() const {
+            std::string str = Util::positionToString(start());
+            str += Util::positionToString(end());
+            if (promotionType() != Pieces::EMPTY) str += Util::pieceToString(promotionType(), Color::BLACK);
+            return str;
+        }
+    };
+
+    inline std::ostream &operator<<(std::ostream &os, const PackedMove &move) {
+        os << move.toString();
+        return os;
+    }
+
+    constexpr PackedMove NULL_PACKED_MOVE{};
+
+    // Fixed-capacity move buffer, lives on the stack of the search so generating
+    // moves never touches the allocator. 256 covers the densest known positions.
+    struct MoveList {
+        std::array<Move, 256> moves;
+        int count = 0;
+
+        void push_back(const Move &move) { moves[count++] = move; }
+
+        int size() const { return count; }
+
+        bool empty() const { return count == 0; }
+
+        const Move &operator[](const int index) const { return moves[index]; }
+
+        const Move *begin() const { return moves.data(); }
+
+        const Move *end() const { return moves.data() + count; }
+    };
+
 
     constexpr Move NULL_MOVE = Move{0, 0, Pieces::EMPTY, QUIET, Color::WHITE};
 
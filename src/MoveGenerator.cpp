@@ -1,221 +1,341 @@
 #include "MoveGenerator.h"
 
-std::vector<Move> MoveGenerator::pseudoLegalMoves(const ChessBoard&board) {
-	std::vector<Move> moves;
-
-	const std::vector<Piece>* pieceList = (board.sideToMove == WHITE) ? &board.whitePieces : &board.blackPieces;
-
-	for (const Piece&piece: *pieceList) {
-		for (int i = 0; i < OFFSETS[piece.type]; ++i) {
-			int_fast8_t n = piece.position;
-			while (true) {
-				n = MAILBOX[MAILBOX64[n] + OFFSET[piece.type][i]];
-				if (n == -1) break;
-				Square target = board.squares[n];
-				if (target.type != EMPTY) {
-					if (target.color != board.sideToMove)
-						moves.push_back(
-							{piece.position, n, EMPTY, static_cast<MoveFlag>(target.type), board.sideToMove});
-					break;
-				}
-				moves.push_back({piece.position, n, EMPTY, QUIET, board.sideToMove});
-				if (!SLIDE[piece.type]) break;
-			}
-		}
+#include <atomic>
+#include <thread>
+#include <vector>
 
-		if (piece.type == KING && !inCheck(board, board.sideToMove)) {
-			const int_fast8_t kingPosition = piece.position;
-			if ((board.castlingRights.whiteKingSide && board.sideToMove == WHITE) ||
-			    (board.castlingRights.blackKingSide && board.sideToMove == BLACK)) {
-				if (!isSquareAttacked(board, kingPosition + 1, board.sideToMove) &&
-				    board.squares[kingPosition + 1].type == EMPTY &&
-				    !isSquareAttacked(board, kingPosition + 2, board.sideToMove) &&
-				    board.squares[kingPosition + 2].type == EMPTY) {
-					moves.push_back({
-						kingPosition, static_cast<int_fast8_t>(kingPosition + 2), EMPTY, CASTLEKINGSIDE,
-						board.sideToMove
-					});
-				}
-			}
-			if ((board.castlingRights.whiteQueenSide && board.sideToMove == WHITE) ||
-			    (board.castlingRights.blackQueenSide && board.sideToMove == BLACK)) {
-				if (!isSquareAttacked(board, kingPosition - 1, board.sideToMove) &&
-				    board.squares[kingPosition - 1].type == EMPTY &&
-				    !isSquareAttacked(board, kingPosition - 2, board.sideToMove) &&
-				    board.squares[kingPosition - 2].type == EMPTY &&
-				    board.squares[kingPosition - 3].type == EMPTY) {
-					moves.push_back({
-						kingPosition, static_cast<int_fast8_t>(kingPosition - 2), EMPTY, CASTLEQUEENSIDE,
-						board.sideToMove
-					});
-				}
+void MoveGenerator::pseudoLegalMoves(const ChessBoard&board, MoveList&moves) {
+	tacticalMoves(board, moves);
+	quietMoves(board, moves);
+}
+
+void MoveGenerator::tacticalMoves(const ChessBoard&board, MoveList&moves) {
+	if (board.sideToMove == WHITE) sidedTacticalMoves<WHITE>(board, moves);
+	else sidedTacticalMoves<BLACK>(board, moves);
+}
+
+void MoveGenerator::quietMoves(const ChessBoard&board, MoveList&moves) {
+	if (board.sideToMove == WHITE) sidedQuietMoves<WHITE>(board, moves);
+	else sidedQuietMoves<BLACK>(board, moves);
+}
+
+void MoveGenerator::evasionMoves(const ChessBoard&board, MoveList&moves) {
+	if (board.sideToMove == WHITE) sidedEvasionMoves<WHITE>(board, moves);
+	else sidedEvasionMoves<BLACK>(board, moves);
+}
+
+template<Color side>
+void MoveGenerator::sidedTacticalMoves(const ChessBoard&board, MoveList&moves) {
+	constexpr Color enemy = (side == WHITE) ? BLACK : WHITE;
+	constexpr int_fast8_t sign = (side == WHITE) ? -1 : 1;
+	const uint64_t occupied = board.occupied();
+	const uint64_t enemyPieces = board.occupancy[enemy];
+
+	for (const Type type: {KNIGHT, BISHOP, ROOK, QUEEN, KING}) {
+		uint64_t pieces = board.pieces(side, type);
+		while (pieces) {
+			const int_fast8_t from = Bitboards::popLsb(pieces);
+			uint64_t targets = Bitboards::attacks(type, occupied, from) & enemyPieces;
+			while (targets) {
+				const int_fast8_t to = Bitboards::popLsb(targets);
+				moves.push_back({from, to, EMPTY, static_cast<MoveFlag>(board.squares[to].type), side});
 			}
 		}
 	}
 
-	const std::vector<int_fast8_t>* pawnList = (board.sideToMove == WHITE) ? &board.whitePawns : &board.blackPawns;
+	uint64_t pawns = board.pieces(side, PAWN);
 
-	for (const int_fast8_t&pawnPosition: *pawnList) {
-		const int_fast8_t sign = (board.sideToMove == WHITE) ? -1 : 1;
+	while (pawns) {
+		const int_fast8_t pawnPosition = Bitboards::popLsb(pawns);
 
-		const int_fast8_t pushTarget = pawnPosition + (sign * OFFSET[PAWN][0]);
-		if (board.squares[pushTarget].type == EMPTY) {
-			if (pushTarget <= 7 || pushTarget >= 56) {
-				moves.push_back({pawnPosition, pushTarget, KNIGHT, QUIET, board.sideToMove});
-				moves.push_back({pawnPosition, pushTarget, BISHOP, QUIET, board.sideToMove});
-				moves.push_back({pawnPosition, pushTarget, ROOK, QUIET, board.sideToMove});
-				moves.push_back({pawnPosition, pushTarget, QUEEN, QUIET, board.sideToMove});
-			}
-			else {
-				moves.push_back({pawnPosition, pushTarget, EMPTY, QUIET, board.sideToMove});
-				if (pawnPosition < 16 || pawnPosition >= 48) {
-					const int_fast8_t doublePushTarget = pawnPosition + (sign * OFFSET[PAWN][3]);
-					if (board.squares[doublePushTarget].type == EMPTY)
-						moves.push_back(
-							{pawnPosition, doublePushTarget, EMPTY, DOUBLEPAWNPUSH, board.sideToMove});
-				}
-			}
+		const int_fast8_t pushTarget = pawnPosition + (sign * 8);
+		const bool pushPromotes = (side == WHITE) ? pushTarget <= 7 : pushTarget >= 56;
+		if (pushPromotes && !(occupied & Bitboards::bit(pushTarget))) {
+			moves.push_back({pawnPosition, pushTarget, KNIGHT, QUIET, side});
+			moves.push_back({pawnPosition, pushTarget, BISHOP, QUIET, side});
+			moves.push_back({pawnPosition, pushTarget, ROOK, QUIET, side});
+			moves.push_back({pawnPosition, pushTarget, QUEEN, QUIET, side});
 		}
-		for (int i = 1; i < 3; ++i) {
-			const int_fast8_t n = MAILBOX[MAILBOX64[pawnPosition] + (sign * OFFSET[PAWN][i])];
-			if (n == -1) continue;
-			Square target = board.squares[n];
-			if (target.type != EMPTY && target.color != board.sideToMove) {
-				if (n <= 7 || n >= 56) {
-					moves.push_back(
-						{pawnPosition, n, KNIGHT, static_cast<MoveFlag>(target.type), board.sideToMove});
-					moves.push_back(
-						{pawnPosition, n, BISHOP, static_cast<MoveFlag>(target.type), board.sideToMove});
-					moves.push_back(
-						{pawnPosition, n, ROOK, static_cast<MoveFlag>(target.type), board.sideToMove});
-					moves.push_back(
-						{pawnPosition, n, QUEEN, static_cast<MoveFlag>(target.type), board.sideToMove});
-				}
-				else
-					moves.push_back(
-						{pawnPosition, n, EMPTY, static_cast<MoveFlag>(target.type), board.sideToMove});
-			}
-			if (board.enPassantSquare != -1) {
-				const int_fast8_t enPassantTarget = n - (sign * OFFSET[PAWN][0]);
-				if (enPassantTarget == board.enPassantSquare)
-					moves.push_back({pawnPosition, n, EMPTY, ENPASSANT, board.sideToMove});
+
+		uint64_t captures = Bitboards::pawnAttacks(side, pawnPosition) & enemyPieces;
+		while (captures) {
+			const int_fast8_t n = Bitboards::popLsb(captures);
+			const auto flag = static_cast<MoveFlag>(board.squares[n].type);
+			const bool capturePromotes = (side == WHITE) ? n <= 7 : n >= 56;
+			if (capturePromotes) {
+				moves.push_back({pawnPosition, n, KNIGHT, flag, side});
+				moves.push_back({pawnPosition, n, BISHOP, flag, side});
+				moves.push_back({pawnPosition, n, ROOK, flag, side});
+				moves.push_back({pawnPosition, n, QUEEN, flag, side});
 			}
+			else moves.push_back({pawnPosition, n, EMPTY, flag, side});
 		}
-	}
 
-	return moves;
+		if (board.enPassantSquare != -1) {
+			// the stored square is the captured pawn, the capture lands behind it
+			const int_fast8_t landing = board.enPassantSquare + (sign * 8);
+			if (Bitboards::pawnAttacks(side, pawnPosition) & Bitboards::bit(landing))
+				moves.push_back({pawnPosition, landing, EMPTY, ENPASSANT, side});
+		}
+	}
 }
 
-std::vector<Move> MoveGenerator::tacticalMoves(const ChessBoard&board) {
-	std::vector<Move> moves;
-
-	const std::vector<Piece>* pieceList = (board.sideToMove == WHITE) ? &board.whitePieces : &board.blackPieces;
-
-	for (const Piece&piece: *pieceList) {
-		for (int i = 0; i < OFFSETS[piece.type]; ++i) {
-			int_fast8_t n = piece.position;
-			while (true) {
-				n = MAILBOX[MAILBOX64[n] + OFFSET[piece.type][i]];
-				if (n == -1) break;
-				Square target = board.squares[n];
-				if (target.type != EMPTY) {
-					if (target.color != board.sideToMove)
-						moves.push_back(
-							{piece.position, n, EMPTY, static_cast<MoveFlag>(target.type), board.sideToMove});
-					break;
-				}
-				if (!SLIDE[piece.type]) break;
+template<Color side>
+void MoveGenerator::sidedQuietMoves(const ChessBoard&board, MoveList&moves) {
+	constexpr int_fast8_t sign = (side == WHITE) ? -1 : 1;
+	const uint64_t occupied = board.occupied();
+
+	for (const Type type: {KNIGHT, BISHOP, ROOK, QUEEN, KING}) {
+		uint64_t pieces = board.pieces(side, type);
+		while (pieces) {
+			const int_fast8_t from = Bitboards::popLsb(pieces);
+			uint64_t targets = Bitboards::attacks(type, occupied, from) & ~occupied;
+			while (targets) {
+				const int_fast8_t to = Bitboards::popLsb(targets);
+				moves.push_back({from, to, EMPTY, QUIET, side});
 			}
 		}
 	}
 
-	const std::vector<int_fast8_t>* pawnList = (board.sideToMove == WHITE) ? &board.whitePawns : &board.blackPawns;
-
-	for (const int_fast8_t&pawnPosition: *pawnList) {
-		const int_fast8_t sign = (board.sideToMove == WHITE) ? -1 : 1;
-
-		const int_fast8_t pushTarget = pawnPosition + (sign * OFFSET[PAWN][0]);
-		if (board.squares[pushTarget].type == EMPTY) {
-			if (pushTarget <= 7 || pushTarget >= 56) {
-				moves.push_back({pawnPosition, pushTarget, KNIGHT, QUIET, board.sideToMove});
-				moves.push_back({pawnPosition, pushTarget, BISHOP, QUIET, board.sideToMove});
-				moves.push_back({pawnPosition, pushTarget, ROOK, QUIET, board.sideToMove});
-				moves.push_back({pawnPosition, pushTarget, QUEEN, QUIET, board.sideToMove});
+	if (!inCheck(board, side)) {
+		const int_fast8_t kingPosition = (side == WHITE) ? board.whiteKing : board.blackKing;
+		const bool kingSideRight = (side == WHITE)
+			                           ? board.castlingRights.whiteKingSide
+			                           : board.castlingRights.blackKingSide;
+		const bool queenSideRight = (side == WHITE)
+			                            ? board.castlingRights.whiteQueenSide
+			                            : board.castlingRights.blackQueenSide;
+		if (kingSideRight) {
+			if (!isSquareAttacked(board, kingPosition + 1, side) &&
+			    board.squares[kingPosition + 1].type == EMPTY &&
+			    !isSquareAttacked(board, kingPosition + 2, side) &&
+			    board.squares[kingPosition + 2].type == EMPTY) {
+				moves.push_back({
+					kingPosition, static_cast<int_fast8_t>(kingPosition + 2), EMPTY, CASTLEKINGSIDE,
+					side
+				});
 			}
-			for (int i = 1; i < 3; ++i) {
-				const int_fast8_t n = MAILBOX[MAILBOX64[pawnPosition] + (sign * OFFSET[PAWN][i])];
-				if (n == -1) continue;
-				Square target = board.squares[n];
-				if (target.type != EMPTY && target.color != board.sideToMove) {
-					if (n <= 7 || n >= 56) {
-						moves.push_back(
-							{pawnPosition, n, KNIGHT, static_cast<MoveFlag>(target.type), board.sideToMove});
-						moves.push_back(
-							{pawnPosition, n, BISHOP, static_cast<MoveFlag>(target.type), board.sideToMove});
-						moves.push_back(
-							{pawnPosition, n, ROOK, static_cast<MoveFlag>(target.type), board.sideToMove});
-						moves.push_back(
-							{pawnPosition, n, QUEEN, static_cast<MoveFlag>(target.type), board.sideToMove});
-					}
-					else
-						moves.push_back(
-							{pawnPosition, n, EMPTY, static_cast<MoveFlag>(target.type), board.sideToMove});
-				}
-				if (board.enPassantSquare != -1) {
-					const int_fast8_t enPassantTarget = n - (sign * OFFSET[PAWN][0]);
-					if (enPassantTarget == board.enPassantSquare)
-						moves.push_back({pawnPosition, n, EMPTY, ENPASSANT, board.sideToMove});
-				}
+		}
+		if (queenSideRight) {
+			if (!isSquareAttacked(board, kingPosition - 1, side) &&
+			    board.squares[kingPosition - 1].type == EMPTY &&
+			    !isSquareAttacked(board, kingPosition - 2, side) &&
+			    board.squares[kingPosition - 2].type == EMPTY &&
+			    board.squares[kingPosition - 3].type == EMPTY) {
+				moves.push_back({
+					kingPosition, static_cast<int_fast8_t>(kingPosition - 2), EMPTY, CASTLEQUEENSIDE,
+					side
+				});
 			}
 		}
 	}
 
-	return moves;
+	uint64_t pawns = board.pieces(side, PAWN);
+
+	while (pawns) {
+		const int_fast8_t pawnPosition = Bitboards::popLsb(pawns);
+
+		const int_fast8_t pushTarget = pawnPosition + (sign * 8);
+		const bool pushPromotes = (side == WHITE) ? pushTarget <= 7 : pushTarget >= 56;
+		if (!pushPromotes && !(occupied & Bitboards::bit(pushTarget))) {
+			moves.push_back({pawnPosition, pushTarget, EMPTY, QUIET, side});
+			const bool onStartRank = (side == WHITE) ? pawnPosition >= 48 : pawnPosition < 16;
+			if (onStartRank) {
+				const int_fast8_t doublePushTarget = pawnPosition + (sign * 16);
+				if (!(occupied & Bitboards::bit(doublePushTarget)))
+					moves.push_back({pawnPosition, doublePushTarget, EMPTY, DOUBLEPAWNPUSH, side});
+			}
+		}
+	}
 }
 
 
-bool MoveGenerator::isSquareAttacked(const ChessBoard&board, const int_fast8_t square, const Color color) {
-	const int_fast8_t sign = (color == WHITE) ? -1 : 1;
+template<Color side>
+void MoveGenerator::sidedEvasionMoves(const ChessBoard&board, MoveList&moves) {
+	constexpr Color enemy = (side == WHITE) ? BLACK : WHITE;
+	constexpr int_fast8_t sign = (side == WHITE) ? -1 : 1;
+	const uint64_t occupied = board.occupied();
+	const int_fast8_t kingPosition = (side == WHITE) ? board.whiteKing : board.blackKing;
 
-	//PAWNS
-	for (int i = 1; i < 3; ++i) {
-		const int_fast8_t n = MAILBOX[MAILBOX64[square] + (sign * OFFSET[PAWN][i])];
-		if (n != -1) {
-			if (board.squares[n].type == PAWN && board.squares[n].color != color) return true;
+	// king steps are always candidates, legality filtering catches the ones
+	// that stay on an attacked square
+	uint64_t kingTargets = Bitboards::kingAttacks(kingPosition) & ~board.occupancy[side];
+	while (kingTargets) {
+		const int_fast8_t to = Bitboards::popLsb(kingTargets);
+		moves.push_back({kingPosition, to, EMPTY, static_cast<MoveFlag>(board.squares[to].type), side});
+	}
+
+	uint64_t checkers = board.attackersTo(kingPosition, occupied) & board.occupancy[enemy];
+	// against a double check only the king can move
+	if (!checkers || (checkers & (checkers - 1))) return;
+
+	const int_fast8_t checkerSquare = Bitboards::popLsb(checkers);
+	const Type checkerType = board.squares[checkerSquare].type;
+
+	// capture the checker with a non-king piece
+	uint64_t capturers = board.attackersTo(checkerSquare, occupied) & board.occupancy[side]
+	                     & ~Bitboards::bit(kingPosition);
+	while (capturers) {
+		const int_fast8_t from = Bitboards::popLsb(capturers);
+		if (board.squares[from].type == PAWN &&
+		    ((side == WHITE) ? checkerSquare <= 7 : checkerSquare >= 56)) {
+			moves.push_back({from, checkerSquare, KNIGHT, static_cast<MoveFlag>(checkerType), side});
+			moves.push_back({from, checkerSquare, BISHOP, static_cast<MoveFlag>(checkerType), side});
+			moves.push_back({from, checkerSquare, ROOK, static_cast<MoveFlag>(checkerType), side});
+			moves.push_back({from, checkerSquare, QUEEN, static_cast<MoveFlag>(checkerType), side});
+		} else {
+			moves.push_back({from, checkerSquare, EMPTY, static_cast<MoveFlag>(checkerType), side});
 		}
 	}
-	//KNIGHTS
-	for (int i = 0; i < OFFSETS[KNIGHT]; ++i) {
-		const int_fast8_t n = MAILBOX[MAILBOX64[square] + OFFSET[KNIGHT][i]];
-		if (n != -1) {
-			if (board.squares[n].type == KNIGHT && board.squares[n].color != color) return true;
+
+	// a double-pushed pawn giving check can also be captured en passant
+	if (board.enPassantSquare == checkerSquare) {
+		const int_fast8_t landing = checkerSquare + (sign * 8);
+		uint64_t epCapturers = Bitboards::pawnAttacks(enemy, landing) & board.pieces(side, PAWN);
+		while (epCapturers) {
+			const int_fast8_t from = Bitboards::popLsb(epCapturers);
+			moves.push_back({from, landing, EMPTY, ENPASSANT, side});
 		}
 	}
-	//REST
-	for (int i = 0; i < OFFSETS[QUEEN]; ++i) {
-		int_fast8_t n = square;
-		const int_fast8_t offset = OFFSET[QUEEN][i];
-		bool sliding = false;
-		while (true) {
-			n = MAILBOX[MAILBOX64[n] + offset];
-			if (n == -1) break;
-			const Square target = board.squares[n];
-			if (target.type != EMPTY) {
-				if (target.color != color && (SLIDE[target.type] || !sliding) && target.type != PAWN &&
-				    target.type != KNIGHT) {
-					if (target.type == QUEEN || target.type == KING) return true;
-					if (i % 2 == 0) {if (target.type == BISHOP) return true;}
-					else {if (target.type == ROOK) return true;}
-				}
-				break;
+
+	if (checkerType != BISHOP && checkerType != ROOK && checkerType != QUEEN) return;
+
+	// with both endpoints in the occupancy the rays from the king and from
+	// the checker overlap exactly on the squares between them
+	uint64_t between;
+	if (Bitboards::rookAttacks(occupied, kingPosition) & Bitboards::bit(checkerSquare))
+		between = Bitboards::rookAttacks(occupied, kingPosition) & Bitboards::rookAttacks(occupied, checkerSquare);
+	else
+		between = Bitboards::bishopAttacks(occupied, kingPosition) & Bitboards::bishopAttacks(occupied, checkerSquare);
+	between &= ~occupied;
+
+	while (between) {
+		const int_fast8_t to = Bitboards::popLsb(between);
+
+		// interpose a non-pawn piece (pawn attacks on an empty square are not
+		// moves, pushes are handled below)
+		uint64_t blockers = board.attackersTo(to, occupied) & board.occupancy[side]
+		                    & ~board.pieces(side, PAWN) & ~Bitboards::bit(kingPosition);
+		while (blockers) {
+			const int_fast8_t from = Bitboards::popLsb(blockers);
+			moves.push_back({from, to, EMPTY, QUIET, side});
+		}
+
+		// pawn pushes onto the blocking square
+		const int_fast8_t pushFrom = to - (sign * 8);
+		if (pushFrom < 0 || pushFrom > 63) continue;
+		if (Bitboards::bit(pushFrom) & board.pieces(side, PAWN)) {
+			const bool pushPromotes = (side == WHITE) ? to <= 7 : to >= 56;
+			if (pushPromotes) {
+				moves.push_back({pushFrom, to, KNIGHT, QUIET, side});
+				moves.push_back({pushFrom, to, BISHOP, QUIET, side});
+				moves.push_back({pushFrom, to, ROOK, QUIET, side});
+				moves.push_back({pushFrom, to, QUEEN, QUIET, side});
+			} else {
+				moves.push_back({pushFrom, to, EMPTY, QUIET, side});
 			}
-			sliding = true;
+		} else if (!(Bitboards::bit(pushFrom) & occupied)) {
+			const int_fast8_t doublePushFrom = to - (sign * 16);
+			// the start rank test also keeps the square on the board
+			const bool onStartRank = (side == WHITE)
+			                         ? doublePushFrom >= 48 && doublePushFrom < 56
+			                         : doublePushFrom >= 8 && doublePushFrom < 16;
+			if (onStartRank && (Bitboards::bit(doublePushFrom) & board.pieces(side, PAWN)))
+				moves.push_back({doublePushFrom, to, EMPTY, DOUBLEPAWNPUSH, side});
 		}
 	}
+}
+
+bool MoveGenerator::isSquareAttacked(const ChessBoard&board, const int_fast8_t square, const Color color) {
+	const Color enemy = invertColor(color);
+	const uint64_t occupied = board.occupied();
+
+	if (Bitboards::pawnAttacks(color, square) & board.pieces(enemy, PAWN)) return true;
+	if (Bitboards::knightAttacks(square) & board.pieces(enemy, KNIGHT)) return true;
+	if (Bitboards::kingAttacks(square) & board.pieces(enemy, KING)) return true;
+	if (Bitboards::bishopAttacks(occupied, square) &
+	    (board.pieces(enemy, BISHOP) | board.pieces(enemy, QUEEN)))
+		return true;
+	if (Bitboards::rookAttacks(occupied, square) &
+	    (board.pieces(enemy, ROOK) | board.pieces(enemy, QUEEN)))
+		return true;
 
 	return false;
 }
 
+MoveGenerator::Legality MoveGenerator::analyzeLegality(const ChessBoard&board) {
+	const Color side = board.sideToMove;
+	const Color enemy = invertColor(side);
+	const uint64_t occupied = board.occupied();
+	const int_fast8_t kingPosition = (side == WHITE) ? board.whiteKing : board.blackKing;
+
+	Legality legality{};
+	legality.kingSquare = kingPosition;
+	legality.checkers = board.attackersTo(kingPosition, occupied) & board.occupancy[enemy];
+
+	legality.checkMask = ~0ULL;
+	if (legality.checkers) {
+		uint64_t checkers = legality.checkers;
+		const int_fast8_t checkerSquare = Bitboards::popLsb(checkers);
+		legality.checkMask = Bitboards::bit(checkerSquare);
+		const Type checkerType = board.squares[checkerSquare].type;
+		if (checkerType == BISHOP || checkerType == ROOK || checkerType == QUEEN) {
+			// both endpoints block the rays, so the overlap is exactly the
+			// squares between king and checker
+			if (Bitboards::rookAttacks(occupied, kingPosition) & Bitboards::bit(checkerSquare))
+				legality.checkMask |= Bitboards::rookAttacks(occupied, kingPosition) &
+						Bitboards::rookAttacks(occupied, checkerSquare);
+			else
+				legality.checkMask |= Bitboards::bishopAttacks(occupied, kingPosition) &
+						Bitboards::bishopAttacks(occupied, checkerSquare);
+		}
+	}
+
+	// candidate pinners: enemy sliders aligned with the king on an empty board
+	uint64_t snipers = (Bitboards::rookAttacks(0, kingPosition) &
+	                    (board.pieces(enemy, ROOK) | board.pieces(enemy, QUEEN)))
+	                   | (Bitboards::bishopAttacks(0, kingPosition) &
+	                      (board.pieces(enemy, BISHOP) | board.pieces(enemy, QUEEN)));
+	while (snipers) {
+		const int_fast8_t sniper = Bitboards::popLsb(snipers);
+		uint64_t between;
+		if (Bitboards::rookAttacks(0, kingPosition) & Bitboards::bit(sniper))
+			between = Bitboards::rookAttacks(occupied, kingPosition) & Bitboards::rookAttacks(occupied, sniper);
+		else
+			between = Bitboards::bishopAttacks(occupied, kingPosition) & Bitboards::bishopAttacks(occupied, sniper);
+		// exactly one piece between them, and it is ours: a pin
+		const uint64_t blocker = between & occupied;
+		if (blocker && !(blocker & (blocker - 1)) && (blocker & board.occupancy[side]))
+			legality.pinned |= blocker;
+	}
+
+	return legality;
+}
+
+bool MoveGenerator::isLegal(const ChessBoard&board, const Move&move, const Legality&legality) {
+	if (move.start == legality.kingSquare) {
+		// castling is generated fully validated, a normal king step just has
+		// to land on a safe square - with the king lifted off the board so a
+		// checker's ray is not considered blocked behind it
+		if (move.flag == CASTLEKINGSIDE || move.flag == CASTLEQUEENSIDE) return true;
+		const uint64_t occupiedWithoutKing = board.occupied() ^ Bitboards::bit(legality.kingSquare);
+		return !(board.attackersTo(move.end, occupiedWithoutKing) &
+		         board.occupancy[invertColor(board.sideToMove)]);
+	}
+
+	if (legality.checkers) {
+		// a non-king move only helps against a single check, by capturing the
+		// checker or blocking its ray
+		if (legality.checkers & (legality.checkers - 1)) return false;
+		if (!(legality.checkMask & Bitboards::bit(move.end))) return false;
+	}
+
+	if (legality.pinned & Bitboards::bit(move.start))
+		return Bitboards::line(legality.kingSquare, move.start) & Bitboards::bit(move.end);
+
+	return true;
+}
+
 bool MoveGenerator::inCheck(const ChessBoard&board, Color color) {
 	const int_fast8_t kingPosition = (color == WHITE) ? board.whiteKing : board.blackKing;
 
@@ -226,20 +346,77 @@ uint64_t MoveGenerator::perft(int depth, ChessBoard&board) {
 	if (depth == 0) return 1ULL;
     uint64_t nodes = 0ULL;
 
-	const std::vector<Move> moves = pseudoLegalMoves(board);
+	MoveList moves;
+	pseudoLegalMoves(board, moves);
+	const Legality legality = analyzeLegality(board);
 
 	for (const Move move: moves) {
-		board.makeMove(move);
-		if (!inCheck(board, invertColor(board.sideToMove))) {
-			const uint64_t childNodes = perft(depth - 1, board);
-			nodes += childNodes;
+		if (move.flag == ENPASSANT) {
+			// the capture empties two squares on the king's rank at once,
+			// still cheapest to settle by playing it out
+			board.makeMove(move);
+			if (!inCheck(board, invertColor(board.sideToMove))) nodes += perft(depth - 1, board);
+			board.unMakeMove();
+			continue;
+		}
+		if (!isLegal(board, move, legality)) continue;
+		if (depth == 1) {
+			// frontier moves are already proven legal, count without playing
+			++nodes;
+			continue;
 		}
+		board.makeMove(move);
+		nodes += perft(depth - 1, board);
 		board.unMakeMove();
 	}
 
 	return nodes;
 }
 
+uint64_t MoveGenerator::perftParallel(int depth, ChessBoard&board, int threads) {
+	if (depth <= 1 || threads <= 1) return perft(depth, board);
+
+	MoveList moves;
+	pseudoLegalMoves(board, moves);
+	const Legality legality = analyzeLegality(board);
+
+	// collect the legal root moves up front, the workers then pull them off a
+	// shared index - cheap load balancing since subtree sizes vary wildly
+	MoveList rootMoves;
+	for (const Move move: moves) {
+		if (move.flag == ENPASSANT) {
+			board.makeMove(move);
+			const bool legal = !inCheck(board, invertColor(board.sideToMove));
+			board.unMakeMove();
+			if (!legal) continue;
+		} else if (!isLegal(board, move, legality)) continue;
+		rootMoves.push_back(move);
+	}
+
+	std::atomic<uint64_t> nodes = 0;
+	std::atomic<int> nextMove = 0;
+
+	auto worker = [&]() {
+		ChessBoard workerBoard = board;
+		uint64_t localNodes = 0;
+		int i;
+		while ((i = nextMove.fetch_add(1)) < rootMoves.size()) {
+			workerBoard.makeMove(rootMoves[i]);
+			localNodes += perft(depth - 1, workerBoard);
+			workerBoard.unMakeMove();
+		}
+		nodes.fetch_add(localNodes);
+	};
+
+	std::vector<std::thread> pool;
+	const int workerCount = std::min(threads, rootMoves.size());
+	pool.reserve(workerCount);
+	for (int i = 0; i < workerCount; ++i) pool.emplace_back(worker);
+	for (std::thread &thread: pool) thread.join();
+
+	return nodes;
+}
+
 bool MoveGenerator::isLegalMove(ChessBoard&board, Move move) {
 	bool isLegal = false;
 	board.makeMove(move);
@@ -6,12 +6,45 @@
 
 class MoveGenerator {
 public:
-    static std::vector<Move> pseudoLegalMoves(const ChessBoard& board);
-    static std::vector<Move> tacticalMoves(const ChessBoard& board);
+    // pinned pieces and checkers of the side to move, computed once per node
+    // so pseudo-legal moves can be validated without make/unmake round trips
+    struct Legality {
+        uint64_t pinned;
+        uint64_t checkers;
+        // squares that resolve a single check (capture or interposition),
+        // all squares when not in check
+        uint64_t checkMask;
+        int_fast8_t kingSquare;
+    };
+
+    static Legality analyzeLegality(const ChessBoard& board);
+    // validates a pseudo-legal move against precomputed pin and check masks,
+    // en passant is the only case still settled by make/unmake
+    static bool isLegal(const ChessBoard& board, const Move& move, const Legality& legality);
+
+    static void pseudoLegalMoves(const ChessBoard& board, MoveList& moves);
+    static void tacticalMoves(const ChessBoard& board, MoveList& moves);
+    static void quietMoves(const ChessBoard& board, MoveList& moves);
+    // moves that may resolve a check: king steps, captures of the checker and
+    // interpositions - much smaller than the full pseudo-legal set
+    static void evasionMoves(const ChessBoard& board, MoveList& moves);
     static bool isSquareAttacked(const ChessBoard& board, int_fast8_t square, Color color);
     static bool inCheck(const ChessBoard& board, Color color);
     static uint64_t perft(int depth,  ChessBoard& board);
+    // splits the root moves across a pool of worker threads, each counting
+    // its share on a private board copy - results match perft exactly
+    static uint64_t perftParallel(int depth, ChessBoard& board, int threads);
     static bool isLegalMove(ChessBoard &board, Move move);
+
+private:
+    // side-specialized bodies: pawn direction, promotion ranks and castling
+    // rights resolve at compile time, the public entry points dispatch once
+    template<Color side>
+    static void sidedTacticalMoves(const ChessBoard& board, MoveList& moves);
+    template<Color side>
+    static void sidedQuietMoves(const ChessBoard& board, MoveList& moves);
+    template<Color side>
+    static void sidedEvasionMoves(const ChessBoard& board, MoveList& moves);
 };
 
 #endif //CHESSENGINE_MOVEGENERATOR_H
@@ -0,0 +1,208 @@
+#include "MovePicker.h"
+
+#include "EvaluationValues.h"
+#include "MoveGenerator.h"
+
+using namespace EvaluationValues;
+
+MovePicker::MovePicker(const ChessBoard &board, const PackedMove hashMove, const std::array<PackedMove, 2> &killers,
+                       const HistoryTable &history, const PackedMove counterMove, const ContinuationEntry *continuation)
+        : board(board), hashMove(board.expandMove(hashMove)),
+          killers{board.expandMove(killers[0]), board.expandMove(killers[1])}, history(&history),
+          counterMove(board.expandMove(counterMove)), continuation(continuation), tacticalOnly(false) {
+}
+
+MovePicker::MovePicker(const ChessBoard &board, const PackedMove hashMove)
+        : board(board), hashMove(board.expandMove(hashMove)), killers{NULL_MOVE, NULL_MOVE}, history(nullptr),
+          counterMove(NULL_MOVE), continuation(nullptr), tacticalOnly(true) {
+}
+
+Move MovePicker::next() {
+    while (true) {
+        switch (stage) {
+            case HASH:
+                stage = GENERATE_TACTICALS;
+                // a hash move comes straight out of the table, so unlike generated
+                // moves it has to be validated before it can be played
+                if (hashMove != NULL_MOVE) {
+                    if (isPseudoLegal(hashMove)) return hashMove;
+                    hashMove = NULL_MOVE;
+                }
+                break;
+            case GENERATE_TACTICALS:
+                MoveGenerator::tacticalMoves(board, moves);
+                scoreTacticals();
+                stage = TACTICALS;
+                break;
+            case TACTICALS:
+                while (index < moves.size()) {
+                    const Move move = selectBest();
+                    // in quiescence a SEE-losing capture is not worth searching,
+                    // and selection order means the rest are losing too
+                    if (tacticalOnly && scores[index - 1] < 0) {
+                        index = moves.count;
+                        break;
+                    }
+                    if (move == hashMove) continue;
+                    return move;
+                }
+                stage = tacticalOnly ? DONE : KILLERS;
+                break;
+            case KILLERS:
+                while (killerIndex < 2) {
+                    const Move killer = killers[killerIndex++];
+                    if (killer == NULL_MOVE || killer == hashMove) continue;
+                    if (!isPseudoLegalQuiet(killer)) continue;
+                    yieldedKillers[yieldedKillerCount++] = killer;
+                    return killer;
+                }
+                stage = COUNTER;
+                break;
+            case COUNTER:
+                // the quiet that refuted the previous move last time it was
+                // played, tried right after the killers
+                stage = GENERATE_QUIETS;
+                if (counterMove != NULL_MOVE && counterMove != hashMove &&
+                    counterMove != yieldedKillers[0] && counterMove != yieldedKillers[1] &&
+                    isPseudoLegalQuiet(counterMove)) {
+                    yieldedCounter = counterMove;
+                    return counterMove;
+                }
+                break;
+            case GENERATE_QUIETS:
+                moves.count = 0;
+                index = 0;
+                MoveGenerator::quietMoves(board, moves);
+                scoreQuiets();
+                stage = QUIETS;
+                break;
+            case QUIETS:
+                while (index < moves.size()) {
+                    const Move move = selectBest();
+                    if (move == hashMove || move == yieldedKillers[0] || move == yieldedKillers[1] ||
+                        move == yieldedCounter)
+                        continue;
+                    return move;
+                }
+                stage = DONE;
+                break;
+            case DONE:
+                return NULL_MOVE;
+        }
+    }
+}
+
+Move MovePicker::selectBest() {
+    int best = index;
+    for (int i = index + 1; i < moves.size(); ++i) {
+        if (scores[i] > scores[best]) best = i;
+    }
+    std::swap(moves.moves[index], moves.moves[best]);
+    std::swap(scores[index], scores[best]);
+    return moves.moves[index++];
+}
+
+// captures are ordered by static exchange evaluation, so a defended pawn
+// taken by a queen sorts below an even trade instead of exploding quiescence
+void MovePicker::scoreTacticals() {
+    for (int i = 0; i < moves.size(); ++i) {
+        const Move &move = moves[i];
+        int score = board.see(move);
+        if (move.promotionType != EMPTY) score += mg_value[move.promotionType - 1] - mg_value[0];
+        scores[i] = score;
+    }
+}
+
+void MovePicker::scoreQuiets() {
+    for (int i = 0; i < moves.size(); ++i) {
+        const Move &move = moves[i];
+        int score = (*history)[board.sideToMove][move.start][move.end];
+        if (continuation) score += (*continuation)[board.squares[move.start].type - 1][move.end];
+        scores[i] = score;
+    }
+}
+
+bool MovePicker::isPseudoLegal(const Move &move) const {
+    if (move.start < 0 || move.end < 0) return false;
+    if (move.player != board.sideToMove) return false;
+    const Square piece = board.squares[move.start];
+    if (piece.type == EMPTY || piece.color != board.sideToMove) return false;
+
+    const Square target = board.squares[move.end];
+    const bool isCapture = move.flag > 0 && move.flag < 6;
+    if (isCapture) {
+        if (target.type != static_cast<Type>(move.flag) || target.color == board.sideToMove) return false;
+    } else if (move.flag != ENPASSANT && target.type != EMPTY) return false;
+
+    const int_fast8_t sign = (board.sideToMove == WHITE) ? -1 : 1;
+
+    if (piece.type == PAWN) {
+        if (move.flag == ENPASSANT) {
+            return board.enPassantSquare != -1 &&
+                   move.end == board.enPassantSquare + (sign * 8) &&
+                   (Bitboards::pawnAttacks(board.sideToMove, move.start) & Bitboards::bit(move.end));
+        }
+        if (move.flag == DOUBLEPAWNPUSH) {
+            return move.promotionType == EMPTY &&
+                   move.end == move.start + (sign * 16) &&
+                   (move.start < 16 || move.start >= 48) &&
+                   board.squares[move.start + (sign * 8)].type == EMPTY;
+        }
+        if (move.flag >= CASTLEKINGSIDE) return false;
+        const bool promotionRank = move.end <= 7 || move.end >= 56;
+        if (promotionRank != (move.promotionType != EMPTY)) return false;
+        if (isCapture) return Bitboards::pawnAttacks(board.sideToMove, move.start) & Bitboards::bit(move.end);
+        return move.end == move.start + (sign * 8);
+    }
+
+    if (move.promotionType != EMPTY) return false;
+
+    if (move.flag == CASTLEKINGSIDE || move.flag == CASTLEQUEENSIDE) {
+        if (piece.type != KING || MoveGenerator::inCheck(board, board.sideToMove)) return false;
+        const ChessBoard::CastlingRights &rights = board.castlingRights;
+        if (move.flag == CASTLEKINGSIDE) {
+            const bool hasRight = (board.sideToMove == WHITE) ? rights.whiteKingSide : rights.blackKingSide;
+            return hasRight && move.end == move.start + 2 &&
+                   board.squares[move.start + 1].type == EMPTY &&
+                   board.squares[move.start + 2].type == EMPTY &&
+                   !MoveGenerator::isSquareAttacked(board, move.start + 1, board.sideToMove) &&
+                   !MoveGenerator::isSquareAttacked(board, move.start + 2, board.sideToMove);
+        }
+        const bool hasRight = (board.sideToMove == WHITE) ? rights.whiteQueenSide : rights.blackQueenSide;
+        return hasRight && move.end == move.start - 2 &&
+               board.squares[move.start - 1].type == EMPTY &&
+               board.squares[move.start - 2].type == EMPTY &&
+               board.squares[move.start - 3].type == EMPTY &&
+               !MoveGenerator::isSquareAttacked(board, move.start - 1, board.sideToMove) &&
+               !MoveGenerator::isSquareAttacked(board, move.start - 2, board.sideToMove);
+    }
+
+    if (move.flag == ENPASSANT || move.flag == DOUBLEPAWNPUSH) return false;
+    return Bitboards::attacks(piece.type, board.occupied(), move.start) & Bitboards::bit(move.end);
+}
+
+// Cheap validation so a killer from a sibling node is only tried if it is
+// actually playable here. Castling killers are left to the quiet stage, their
+// legality conditions are too involved to re-check in isolation.
+bool MovePicker::isPseudoLegalQuiet(const Move &move) const {
+    if (move.player != board.sideToMove) return false;
+    if (move.flag == CASTLEKINGSIDE || move.flag == CASTLEQUEENSIDE) return false;
+    const Square piece = board.squares[move.start];
+    if (piece.type == EMPTY || piece.color != board.sideToMove) return false;
+    if (board.squares[move.end].type != EMPTY) return false;
+
+    if (piece.type == PAWN) {
+        const int_fast8_t sign = (board.sideToMove == WHITE) ? -1 : 1;
+        if (move.flag == DOUBLEPAWNPUSH) {
+            return move.end == move.start + (sign * 16) &&
+                   (move.start < 16 || move.start >= 48) &&
+                   board.squares[move.start + (sign * 8)].type == EMPTY;
+        }
+        return move.flag == QUIET && move.end == move.start + (sign * 8) && move.end > 7 && move.end < 56;
+    }
+
+    // a stored promotion recalled with a non-pawn on its start square would
+    // otherwise pass the attack test below and promote that piece
+    if (move.flag != QUIET || move.promotionType != EMPTY) return false;
+    return Bitboards::attacks(piece.type, board.occupied(), move.start) & Bitboards::bit(move.end);
+}
@@ -0,0 +1,64 @@
+#ifndef CHESSENGINE_MOVEPICKER_H
+#define CHESSENGINE_MOVEPICKER_H
+
+#include <array>
+#include "ChessBoard.h"
+#include "Move.h"
+
+using HistoryTable = std::array<std::array<std::array<int, 64>, 64>, 2>;
+// quiet reply that refuted the previous move, keyed on its from and to squares
+using CounterMoveTable = std::array<std::array<PackedMove, 64>, 64>;
+// [piece][to] scores for quiets following one specific previous move
+using ContinuationEntry = std::array<std::array<int, 64>, 6>;
+// 1-ply continuation history, keyed on the previous move's piece and target
+using ContinuationTable = std::array<std::array<ContinuationEntry, 64>, 6>;
+
+// Staged move generator for the search: yields the hash move first, then
+// captures, killers and finally the remaining quiets. A node that fails high
+// on an early stage never pays for generating the later ones.
+class MovePicker {
+public:
+    // full search: all stages; counterMove and continuation belong to the
+    // previous move and may be null at the root. The stored moves arrive in
+    // their 16-bit form and are expanded against the current position here
+    MovePicker(const ChessBoard &board, PackedMove hashMove, const std::array<PackedMove, 2> &killers,
+               const HistoryTable &history, PackedMove counterMove, const ContinuationEntry *continuation);
+
+    // quiescence: hash move and tactical moves only
+    MovePicker(const ChessBoard &board, PackedMove hashMove);
+
+    // next pseudo-legal move in descending order of promise, NULL_MOVE once exhausted
+    Move next();
+
+private:
+    enum Stage { HASH, GENERATE_TACTICALS, TACTICALS, KILLERS, COUNTER, GENERATE_QUIETS, QUIETS, DONE };
+
+    const ChessBoard &board;
+    Move hashMove;
+    std::array<Move, 2> killers;
+    const HistoryTable *history;
+    Move counterMove;
+    const ContinuationEntry *continuation;
+    bool tacticalOnly;
+
+    Stage stage = HASH;
+    MoveList moves;
+    std::array<int, 256> scores{};
+    int index = 0;
+    int killerIndex = 0;
+    std::array<Move, 2> yieldedKillers{NULL_MOVE, NULL_MOVE};
+    int yieldedKillerCount = 0;
+    Move yieldedCounter = NULL_MOVE;
+
+    Move selectBest();
+
+    void scoreTacticals();
+
+    void scoreQuiets();
+
+    bool isPseudoLegalQuiet(const Move &move) const;
+
+    bool isPseudoLegal(const Move &move) const;
+};
+
+#endif //CHESSENGINE_MOVEPICKER_H
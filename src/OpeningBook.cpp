@@ -0,0 +1,129 @@
+#include "OpeningBook.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "MoveGenerator.h"
+#include "MoveParser.h"
+
+const OpeningBook::Record *OpeningBook::records = nullptr;
+size_t OpeningBook::recordCount = 0;
+
+void OpeningBook::load() {
+    if (init("opening_book.bin")) return;
+    if (convert("opening_book.txt", "opening_book.bin")) init("opening_book.bin");
+}
+
+bool OpeningBook::init(const std::string &path) {
+    const int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat info{};
+    if (fstat(fd, &info) < 0 || info.st_size < (off_t) sizeof(Record)) {
+        close(fd);
+        return false;
+    }
+
+    void *mapped = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED) return false;
+
+    records = static_cast<const Record *>(mapped);
+    recordCount = info.st_size / sizeof(Record);
+    return true;
+}
+
+Move OpeningBook::probe(const ChessBoard &board) {
+    if (records == nullptr) return NULL_MOVE;
+
+    const uint64_t key = board.hashCode;
+    size_t low = 0;
+    size_t high = recordCount;
+    while (low < high) {
+        const size_t mid = (low + high) / 2;
+        if (records[mid].key < key) low = mid + 1;
+        else high = mid;
+    }
+
+    uint16_t bestPacked = 0;
+    int bestWeight = -1;
+    for (size_t i = low; i < recordCount && records[i].key == key; ++i) {
+        if (records[i].weight > bestWeight) {
+            bestWeight = records[i].weight;
+            bestPacked = records[i].move;
+        }
+    }
+    if (bestWeight < 0) return NULL_MOVE;
+
+    // the record only stores start/end/promotion, recover the full move (and
+    // reject corrupt records) by matching against the generated moves
+    const auto start = static_cast<int_fast8_t>(bestPacked & 0x3f);
+    const auto end = static_cast<int_fast8_t>((bestPacked >> 6) & 0x3f);
+    const auto promotion = static_cast<Type>((bestPacked >> 12) & 0x7);
+
+    MoveList moves;
+    MoveGenerator::pseudoLegalMoves(board, moves);
+    for (const Move &move: moves) {
+        if (move.start == start && move.end == end && move.promotionType == promotion &&
+            MoveGenerator::isLegalMove(const_cast<ChessBoard &>(board), move))
+            return move;
+    }
+    return NULL_MOVE;
+}
+
+bool OpeningBook::convert(const std::string &textPath, const std::string &binaryPath) {
+    std::ifstream file(textPath);
+    if (!file.is_open()) {
+        std::cerr << "Failed to open opening book" << std::endl;
+        return false;
+    }
+
+    ChessBoard board;
+    board.setStartingPosition();
+    std::map<std::pair<uint64_t, uint16_t>, uint16_t> weights;
+
+    std::string line;
+    std::getline(file, line);
+    weights[{board.hashCode, packMove(parseMove(line, board))}]++;
+
+    while (!file.eof()) {
+        std::getline(file, line);
+        if (line.empty()) continue;
+        if (line[0] == 'm') {
+            std::getline(file, line);
+            board.makeMove(parseMove(line, board));
+
+            std::getline(file, line);
+            weights[{board.hashCode, packMove(parseMove(line, board))}]++;
+        } else if (line[0] == 'u') {
+            board.unMakeMove();
+        }
+    }
+    file.close();
+
+    std::vector<Record> converted;
+    converted.reserve(weights.size());
+    for (const auto &[keyMove, weight]: weights) {
+        converted.push_back({keyMove.first, keyMove.second, weight});
+    }
+    std::sort(converted.begin(), converted.end(), [](const Record &a, const Record &b) {
+        return a.key < b.key;
+    });
+
+    std::ofstream out(binaryPath, std::ios::binary);
+    if (!out.is_open()) return false;
+    out.write(reinterpret_cast<const char *>(converted.data()), converted.size() * sizeof(Record));
+    return out.good();
+}
+
+uint16_t OpeningBook::packMove(const Move &move) {
+    return (move.start & 0x3f) | ((move.end & 0x3f) << 6) | ((move.promotionType & 0x7) << 12);
+}
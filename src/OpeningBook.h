@@ -0,0 +1,41 @@
+#ifndef CHESSENGINE_OPENINGBOOK_H
+#define CHESSENGINE_OPENINGBOOK_H
+
+#include <cstdint>
+#include <string>
+#include "ChessBoard.h"
+
+// Binary opening book: records sorted by position hash, memory-mapped at
+// startup and binary-searched at the root before a search starts. Probing
+// never touches the transposition table, so book lines cannot be evicted
+// by replacement mid-game.
+class OpeningBook {
+public:
+#pragma pack(push, 1)
+    struct Record {
+        uint64_t key; // position hash, requires the fixed HashCodes seed
+        uint16_t move; // start | end << 6 | promotionType << 12
+        uint16_t weight; // how often the line occurred in the source book
+    };
+#pragma pack(pop)
+
+    // maps an existing binary book, converting the text book first if only
+    // that is present
+    static void load();
+
+    static bool init(const std::string &path);
+
+    // best weighted book move for the position, NULL_MOVE when out of book
+    static Move probe(const ChessBoard &board);
+
+    // converts the line-oriented text book into the sorted binary format
+    static bool convert(const std::string &textPath, const std::string &binaryPath);
+
+private:
+    static const Record *records;
+    static size_t recordCount;
+
+    static uint16_t packMove(const Move &move);
+};
+
+#endif //CHESSENGINE_OPENINGBOOK_H
@@ -1,8 +1,9 @@
 #include "Search.h"
+#include "Endgame.h"
 #include "Evaluator.h"
 #include "MoveGenerator.h"
 #include "TranspositionTable.h"
-#include <unordered_set>
+#include <algorithm>
 #include <chrono>
 #include <thread>
 #include <format>
@@ -10,9 +11,13 @@
 #define MATE_SCORE INT32_MAX
 
 TranspositionTable Search::tt = TranspositionTable();
+int Search::threadCount = 1;
+int Search::multiPV = 1;
 
 void Search::doSearch() {
     searchingSemaphore.acquire();
+    searchStart = std::chrono::steady_clock::now();
+    tt.newSearch();
 
     logger.start();
     logger.logToFile("starting search\n");
@@ -49,18 +54,32 @@ Move Search::endSearch(int timeOut) {
     }
     printf("Evaluation: %d\nPV: ", score);
     printf("\nBoard hash: %llu", board.hashCode);
-    printf("\nTT reads: %d", tt.reads);
-    printf("\nTT writes: %d", tt.writes);
-    printf("\nTT collisions: %d", tt.collisions);
-    printf("\nTT occupancy: %d", tt.entryCount);
+    printf("\nTT reads: %d", tt.reads.load());
+    printf("\nTT writes: %d", tt.writes.load());
+    printf("\nTT collisions: %d", tt.collisions.load());
+    printf("\nTT occupancy: %d", tt.entryCount.load());
     printf("\n**************************\n");
     logger.sendInt("updateTTOccupancy", tt.entryCount);
     logger.sendInt("updateEvaluation", score);
 #endif
     tt.resetCounters();
 
-    lastPV = collectPV(lastPV.size() + 1);
+    // an aborted iteration that never improved alpha leaves the root PV row
+    // empty, keep the line from the last completed iteration in that case
+    if (pvLength[0] > 0 || lastPV.empty()) lastPV = collectPV();
+
+    logger.end();
+
     if (lastPV.empty()) {
+        // last resort when even depth one was cut short: any stored root move
+        // beats forfeiting with a null bestmove
+        if (tt.contains(board.hashCode)) {
+            const TranspositionTable::Entry entry = tt.getEntry(board.hashCode, 0);
+            if (entry.bestMove != NULL_PACKED_MOVE) {
+                lastPV.push_back(board.expandMove(entry.bestMove));
+                return lastPV[0];
+            }
+        }
         auto entry = tt.getEntry(board.hashCode, 0);
         std::cout << "problem HASH: " << board.hashCode << " TT: key- " << entry.key << ", move- " << entry.bestMove
                   << ", type- " << entry.nodeType <<
@@ -68,39 +87,105 @@ Move Search::endSearch(int timeOut) {
         return NULL_MOVE;
     }
 
-    logger.end();
-
     return lastPV[0];
 }
 
+void Search::interrupt() {
+    reachedDepthOneSemaphore.acquire();
+    stop = true;
+    reachedDepthOneSemaphore.release();
+}
+
 void Search::threadedSearch() {
-    constexpr int alpha = INT32_MIN + 1;
-    constexpr int beta = INT32_MAX;
+    constexpr int alphaBound = INT32_MIN + 1;
+    constexpr int betaBound = INT32_MAX;
+
+    // report the proven result when the root itself is in the tablebases; the
+    // probes inside the tree then steer the search straight down a conversion
+    int tablebaseScore;
+    if (Endgame::probe(board, tablebaseScore)) {
+        logger.log(std::format("info string tablebase score cp {}\n", tablebaseScore / 10));
+    }
 
     logger.log(std::format("info depth 1\n"));
     logger.logToFile(std::format("starting depth 1\n"));
 
     logger.logToFile("root begin\n");
-    alphaBeta(1, alpha, beta, 0);
+    int previousScore = alphaBeta(1, alphaBound, betaBound, 0);
     logger.logToFile("root end\n");
 
     bool endEarly = false;
 
-    lastPV = collectPV(1, endEarly);
+    lastPV = collectPV(endEarly);
     reachedDepthOneSemaphore.release();
 
+    startHelpers();
+
     int i = std::max((int) lastPV.size(), 2);
+    int64_t lastIterationMs = 0;
 
     for (; i < 64 && !endEarly; ++i) {
+        if (depthLimit && i > depthLimit) break;
+        if (softTimeLimit) {
+            // soft limit: do not start an iteration that is unlikely to
+            // finish, assuming it costs at least twice the previous one
+            const int64_t elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::steady_clock::now() - searchStart).count();
+            if (elapsed + std::max<int64_t>(lastIterationMs * 2, 1) > softTimeLimit) break;
+        }
+        const auto iterationStart = std::chrono::steady_clock::now();
+        SEARCH_STATS(statsIterationStart = nodesSearched);
+
         logger.log(std::format("info depth {}\n", i));
         logger.logToFile(std::format("starting depth {}\n", i));
 
         logger.logToFile("root begin\n");
-        alphaBeta(i, alpha, beta, 0);
+        // aspiration window seeded from the previous iteration, widening
+        // exponentially on the failing side until the score fits
+        int delta = 500;
+        int alpha = std::max<int64_t>((int64_t) previousScore - delta, alphaBound);
+        int beta = std::min<int64_t>((int64_t) previousScore + delta, betaBound);
+        int score;
+        while (true) {
+            score = alphaBeta(i, alpha, beta, 0);
+            if (stop) break;
+            if (score <= alpha && alpha > alphaBound) alpha = std::max<int64_t>((int64_t) alpha - delta, alphaBound);
+            else if (score >= beta && beta < betaBound) beta = std::min<int64_t>((int64_t) beta + delta, betaBound);
+            else break;
+            delta *= 4;
+        }
+        previousScore = score;
         logger.logToFile("root end\n");
         if (stop) break;
 
-        lastPV = collectPV(i, endEarly);
+        // helpers racing ahead can leave the iteration without a line of its
+        // own; never let that replace the one from a completed iteration
+        std::vector<Move> pv = collectPV(endEarly);
+        if (!pv.empty()) lastPV = std::move(pv);
+
+        if (multiPV > 1 && !endEarly) {
+            logMultiPVLine(i, 1, score);
+
+            // the alternatives reuse the tree the main line just built up in
+            // the shared transposition table, so each one is far cheaper than
+            // a fresh search of the same depth
+            const std::array<PackedMove, MAX_PLY> mainLine = pvTable[0];
+            const int mainLineLength = pvLength[0];
+
+            for (int line = 2; line <= multiPV && !stop; ++line) {
+                if (pvLength[0] == 0) break;
+                excludedRootMoves.push_back(pvTable[0][0]);
+                const int lineScore = alphaBeta(i, alphaBound, betaBound, 0);
+                if (stop || pvLength[0] == 0) break;
+                logMultiPVLine(i, line, lineScore);
+            }
+            excludedRootMoves.clear();
+
+            // endSearch rereads the root PV row for the best move, restore it
+            // to the main line
+            pvTable[0] = mainLine;
+            pvLength[0] = mainLineLength;
+        }
 
         if (tt.contains(board.hashCode)) {
             const TranspositionTable::Entry entry = tt.getEntry(board.hashCode, 0);
@@ -111,77 +196,279 @@ void Search::threadedSearch() {
 
 
         i = std::max((int) lastPV.size(), i);
+        lastIterationMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - iterationStart).count();
+        SEARCH_STATS(logIterationStats(i));
     }
+    stopHelpers();
+    SEARCH_STATS(reportStats());
     searchingSemaphore.release();
 }
 
-int Search::alphaBeta(const int depth, int alpha, int beta, const int ply) {
+void Search::setLimits(const int depth, const uint64_t nodes, const int64_t softTimeMs, const int64_t hardTimeMs) {
+    depthLimit = depth;
+    nodeLimit = nodes;
+    softTimeLimit = softTimeMs;
+    hardTimeLimit = hardTimeMs;
+    nodesSearched = 0;
+}
+
+Search::AnalysisResult Search::analyze(const int targetDepth, const uint64_t nodeBudget) {
+    constexpr int alphaBound = INT32_MIN + 1;
+    constexpr int betaBound = INT32_MAX;
+
+    reset();
+    setLimits(0, nodeBudget, 0, 0);
+    tt.newSearch();
+
+    AnalysisResult result{NULL_MOVE, 0, 0, 0};
+
+    int previousScore = alphaBeta(1, alphaBound, betaBound, 0);
+    if (!stop && pvLength[0] > 0) result = {board.expandMove(pvTable[0][0]), previousScore, 1, nodesSearched};
+
+    const int depthCap = targetDepth > 0 ? std::min(targetDepth, 63) : 63;
+    for (int i = 2; i <= depthCap && !stop; ++i) {
+        int delta = 500;
+        int alpha = std::max<int64_t>((int64_t) previousScore - delta, alphaBound);
+        int beta = std::min<int64_t>((int64_t) previousScore + delta, betaBound);
+        int score;
+        while (true) {
+            score = alphaBeta(i, alpha, beta, 0);
+            if (stop) break;
+            if (score <= alpha && alpha > alphaBound) alpha = std::max<int64_t>((int64_t) alpha - delta, alphaBound);
+            else if (score >= beta && beta < betaBound) beta = std::min<int64_t>((int64_t) beta + delta, betaBound);
+            else break;
+            delta *= 4;
+        }
+        if (stop) break;
+        previousScore = score;
+        if (pvLength[0] > 0) result = {board.expandMove(pvTable[0][0]), score, i, nodesSearched};
+        if (TranspositionTable::isMateScore(score)) break;
+    }
+
+    result.nodes = nodesSearched;
+    nodeLimit = 0;
+    stop = false;
+    return result;
+}
+
+void Search::startHelpers() {
+    for (int i = 1; i < threadCount; ++i) {
+        helpers.push_back(std::make_unique<Helper>(board));
+        Search &helper = helpers.back()->search;
+        helper.reset();
+        helperThreads.emplace_back(&Search::helperLoop, &helper, i);
+    }
+}
+
+void Search::stopHelpers() {
+    for (const auto &helper: helpers) helper->search.stop = true;
+    for (std::thread &thread: helperThreads) thread.join();
+    SEARCH_STATS(for (const auto &helper: helpers) stats.add(helper->search.stats));
+    helperThreads.clear();
+    helpers.clear();
+}
+
+// Lazy SMP: each helper runs its own iterative deepening loop over its board
+// copy, with its own killer and history tables. The threads communicate only
+// through the shared transposition table.
+void Search::helperLoop(const int helperIndex) {
+    constexpr int alpha = INT32_MIN + 1;
+    constexpr int beta = INT32_MAX;
+
+    // odd helpers start one ply deeper to desynchronize the pool
+    for (int depth = 2 + (helperIndex & 1); depth < 64 && !stop; ++depth) {
+        alphaBeta(depth, alpha, beta, 0);
+    }
+}
+
+int Search::alphaBeta(const int depth, int alpha, int beta, const int ply, const bool nullAllowed) {
+    ++nodesSearched;
+    SEARCH_STATS(stats.mainNodes++);
+    if (nodeLimit && nodesSearched >= nodeLimit) stop = true;
+    // the hard time limit cuts mid-tree, amortized to one clock read every
+    // few thousand nodes
+    if (hardTimeLimit && (nodesSearched & 4095) == 0 &&
+        std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - searchStart).count() >= hardTimeLimit)
+        stop = true;
     if (stop) { return 0; }
 
+    pvLength[ply] = ply;
+
     if (ply > 0) {
         //repetitions
         if (board.isDraw()) {
-            logger.logToFile("draw, score: 0\n");
+            SEARCH_TRACE(logger, TRACE_DRAW, depth, ply, 0, 0, 0);
             return Util::randomOffset();
         }
 
         alpha = std::max(alpha, -MATE_SCORE + ply);
         beta = std::min(beta, MATE_SCORE - ply);
         if (alpha >= beta) return alpha;
+
+        // with three men or fewer the outcome is a table lookup, no point
+        // searching the subtree
+        if (board.pieceCount[WHITE] + board.pieceCount[BLACK] +
+            board.pawnCount[WHITE] + board.pawnCount[BLACK] <= 3) {
+            int tablebaseScore;
+            if (Endgame::probe(board, tablebaseScore)) {
+                SEARCH_TRACE(logger, TRACE_TRANSPOSITION, depth, ply, 0, 0, tablebaseScore);
+                return tablebaseScore;
+            }
+        }
     }
 
     if (depth < 1) return quiesce(alpha, beta, ply, 0);
 
-    Move hashMove = NULL_MOVE;
+    // with root moves excluded the stored root entry describes a different
+    // move set, so do not overwrite it
+    const bool rootExclusions = ply == 0 && !excludedRootMoves.empty();
+
+    PackedMove hashMove = NULL_PACKED_MOVE;
     int positionScore = 0;
+    SEARCH_STATS(stats.ttProbes++);
     if (getTransposition(board.hashCode, depth, ply, positionScore, alpha, beta, hashMove)) {
-        logger.logToFile(std::format("transposition found | depth: {} score: {}\n", depth, positionScore));
-        return positionScore;
+        SEARCH_TRACE(logger, TRACE_TRANSPOSITION, depth, ply, 0, 0, positionScore);
+        SEARCH_STATS(stats.ttHits++);
+        // never cut from the table at ply 0: the root has to leave a move in
+        // the PV row, the entry only seeds move ordering there
+        if (ply > 0) {
+            SEARCH_STATS(stats.ttCutoffs++);
+            return positionScore;
+        }
+    } else {
+        SEARCH_STATS(stats.ttHits += hashMove != NULL_PACKED_MOVE);
+    }
+
+    const MoveGenerator::Legality legality = MoveGenerator::analyzeLegality(board);
+    const bool inCheck = legality.checkers != 0;
+
+    bool futile = false;
+    if (ply > 0 && !inCheck && !TranspositionTable::isMateScore(beta)) {
+        const int staticEval = Evaluator::evaluate(board);
+
+        // reverse futility pruning: an eval this far above beta at shallow
+        // depth is not coming back down
+        if (depth < 5 && staticEval - 1500 * depth >= beta) return staticEval;
+
+        // null move pruning: if passing the turn still fails high, an actual
+        // move surely would - skipped without pieces to dodge zugzwang
+        const bool hasPieces = board.pieceCount[board.sideToMove] > 1;
+        if (nullAllowed && depth > 2 && hasPieces && staticEval >= beta) {
+            board.makeNullMove();
+            const int nullScore = -alphaBeta(depth - 3, -beta, -beta + 1, ply + 1, false);
+            board.unMakeNullMove();
+            if (stop) return 0;
+            if (nullScore >= beta) {
+                SEARCH_TRACE(logger, TRACE_NULL_CUTOFF, depth, ply, 0, 0, nullScore);
+                return beta;
+            }
+        }
+
+        // futility: quiet moves cannot realistically lift an eval this far
+        // below alpha at frontier depths
+        futile = depth < 4 && staticEval + 1000 + 1200 * depth < alpha;
+    }
+
+    // ordering context from the move that led to this node
+    const Move prevMove = board.plyCount > 0 ? board.undoStack[board.plyCount - 1].move : NULL_MOVE;
+    PackedMove counterMove = NULL_PACKED_MOVE;
+    ContinuationEntry *continuation = nullptr;
+    if (prevMove != NULL_MOVE) {
+        counterMove = counterMoves[prevMove.start][prevMove.end];
+        continuation = &continuationHistory[board.squares[prevMove.end].type - 1][prevMove.end];
     }
 
-    std::vector<ScoredMove> moves = scoreMoves(MoveGenerator::pseudoLegalMoves(board), ply, hashMove);
+    MovePicker picker(board, hashMove, killerMoves[ply], history, counterMove, continuation);
 
     bool hasLegalMoves = false;
 
     TranspositionTable::NodeType nodeType = TranspositionTable::UPPERBOUND;
     Move bestMove = NULL_MOVE;
     int bestScore = INT32_MIN;
+    int moveCount = 0;
 
-    for (int i = 0; i < moves.size(); i++) {
-        Move move = selectMove(moves, i);
-        board.makeMove(move);
-        if (MoveGenerator::inCheck(board, invertColor(board.sideToMove))) {
-            board.unMakeMove();
+    // quiets searched without a cutoff, pushed down in history when a later
+    // quiet refutes the node
+    std::array<Move, 128> triedQuiets;
+    int triedQuietCount = 0;
+
+    for (Move move = picker.next(); move != NULL_MOVE; move = picker.next()) {
+        if (rootExclusions &&
+            std::find(excludedRootMoves.begin(), excludedRootMoves.end(), PackedMove::pack(move)) !=
+            excludedRootMoves.end())
             continue;
+        if (move.flag == ENPASSANT) {
+            // the one case the masks cannot settle, play it out
+            board.makeMove(move);
+            if (MoveGenerator::inCheck(board, invertColor(board.sideToMove))) {
+                board.unMakeMove();
+                continue;
+            }
+        } else {
+            if (!MoveGenerator::isLegal(board, move, legality)) continue;
+            board.makeMove(move);
         }
-        logger.logToFile(move.toString() + " begin\n");
+        SEARCH_TRACE(logger, TRACE_MOVE_BEGIN, depth, ply, move.start, move.end, 0);
 
         hasLegalMoves = true;
+        moveCount++;
 
-        int score = 0;
-
-        // late move reductions
-        bool shouldFullSearch = true;
-        if (i > 2 && depth > 3 && !move.tactical()) {
-            score = -alphaBeta(depth - 2, -alpha - 1, -alpha, ply + 1);
-            shouldFullSearch = score > alpha;
+        // futility and late move pruning: once one legal move is searched,
+        // skip quiets that neither escape nor give check
+        if (moveCount > 1 && !inCheck && !move.tactical() &&
+            (futile || (depth < 4 && moveCount > 3 + depth * depth)) &&
+            !MoveGenerator::inCheck(board, board.sideToMove)) {
+            board.unMakeMove();
+            continue;
         }
 
-        if (shouldFullSearch) score = -alphaBeta(depth - 1, -beta, -alpha, ply + 1);
+        int score;
+
+        // principal variation search: the first move gets the full window,
+        // the rest are scouted with a zero window (reduced when late and
+        // quiet) and only re-searched on fail high
+        if (moveCount == 1) {
+            score = -alphaBeta(depth - 1, -beta, -alpha, ply + 1);
+        } else {
+            const int reduction = (moveCount > 3 && depth > 3 && !move.tactical()) ? 1 : 0;
+            SEARCH_STATS(stats.lmrSearches += reduction > 0);
+            score = -alphaBeta(depth - 1 - reduction, -alpha - 1, -alpha, ply + 1);
+            if (score > alpha && reduction > 0) {
+                SEARCH_STATS(stats.lmrReSearches++);
+                score = -alphaBeta(depth - 1, -alpha - 1, -alpha, ply + 1);
+            }
+            if (score > alpha && score < beta)
+                score = -alphaBeta(depth - 1, -beta, -alpha, ply + 1);
+        }
         board.unMakeMove();
 
-        logger.logToFile(std::format("{} end score : {}\n", move.toString(), score));
+        SEARCH_TRACE(logger, TRACE_MOVE_END, depth, ply, move.start, move.end, score);
 
         if (stop) return 0;
 
         if (score >= beta) {
+            SEARCH_STATS(stats.cutNodes++);
+            SEARCH_STATS(stats.cutoffIndex[std::min(moveCount - 1, 7)]++);
             if (move.flag == 0 || move.flag >= 7) {
                 storeKillerMove(move, ply);
-                history[board.sideToMove][move.start][move.end] += depth * depth;
+                const int bonus = std::min(depth * depth, MAX_HISTORY);
+                applyHistoryGravity(history[board.sideToMove][move.start][move.end], bonus);
+                if (continuation) {
+                    counterMoves[prevMove.start][prevMove.end] = PackedMove::pack(move);
+                    applyHistoryGravity((*continuation)[board.squares[move.start].type - 1][move.end], bonus);
+                }
+                for (int i = 0; i < triedQuietCount; ++i) {
+                    const Move &tried = triedQuiets[i];
+                    applyHistoryGravity(history[board.sideToMove][tried.start][tried.end], -bonus);
+                    if (continuation)
+                        applyHistoryGravity((*continuation)[board.squares[tried.start].type - 1][tried.end], -bonus);
+                }
             }
 
-            tt.setEntry(board, move, depth, score, TranspositionTable::LOWERBOUND, ply);
-            logger.logToFile("beta cutoff\n");
+            if (!rootExclusions) tt.setEntry(board, move, depth, score, TranspositionTable::LOWERBOUND, ply);
+            SEARCH_TRACE(logger, TRACE_BETA_CUTOFF, depth, ply, move.start, move.end, score);
             return score;
         }
         if (score > alpha) {
@@ -189,53 +476,131 @@ int Search::alphaBeta(const int depth, int alpha, int beta, const int ply) {
             bestScore = score;
             bestMove = move;
             nodeType = TranspositionTable::EXACT;
+
+            pvTable[ply][ply] = PackedMove::pack(move);
+            const int childLength = pvLength[ply + 1];
+            for (int next = ply + 1; next < childLength; ++next) pvTable[ply][next] = pvTable[ply + 1][next];
+            pvLength[ply] = childLength;
         } else if (score > bestScore) {
             bestScore = score;
             bestMove = move;
         }
+
+        if ((move.flag == 0 || move.flag >= 7) && triedQuietCount < static_cast<int>(triedQuiets.size()))
+            triedQuiets[triedQuietCount++] = move;
     }
     if (!hasLegalMoves) {
-        if (MoveGenerator::inCheck(board, board.sideToMove)) return -(MATE_SCORE - ply);
+        if (inCheck) return -(MATE_SCORE - ply);
         return 0;
     }
-    logger.logToFile("bestmove " + bestMove.toString() + "\n");
-    tt.setEntry(board, bestMove, depth, alpha, nodeType, ply);
+    SEARCH_TRACE(logger, TRACE_BEST_MOVE, depth, ply, bestMove.start, bestMove.end, alpha);
+    SEARCH_STATS(nodeType == TranspositionTable::EXACT ? stats.pvNodes++ : stats.allNodes++);
+    if (!rootExclusions) tt.setEntry(board, bestMove, depth, alpha, nodeType, ply);
 
     return alpha;
 }
 
 int Search::quiesce(int alpha, int beta, const int ply, const int depth) {
+    ++nodesSearched;
+    SEARCH_STATS(stats.quiesceNodes++);
+    if (nodeLimit && nodesSearched >= nodeLimit) stop = true;
+    if (hardTimeLimit && (nodesSearched & 4095) == 0 &&
+        std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - searchStart).count() >= hardTimeLimit)
+        stop = true;
     if (stop) return 0;
 
+    // terminate the PV here, quiescence lines are not part of it
+    if (ply < MAX_PLY) pvLength[ply] = ply;
+
     //repetitions
     if (board.isDraw()) return Util::randomOffset();
 
-    const int stand_pat = Evaluator::evaluate(board);
-    if (stand_pat >= beta)
-        return beta;
-    if (alpha < stand_pat)
-        alpha = stand_pat;
-    if (stand_pat + mg_value[QUEEN - 1] < alpha) {
-        return alpha;
+    // in check there is no quiet option: stand-pat is off the table and every
+    // evasion has to be searched instead of just the captures
+    const MoveGenerator::Legality legality = MoveGenerator::analyzeLegality(board);
+    const bool inCheck = legality.checkers != 0;
+
+    if (!inCheck) {
+        const int stand_pat = Evaluator::evaluate(board);
+        if (stand_pat >= beta)
+            return beta;
+        if (alpha < stand_pat)
+            alpha = stand_pat;
+        if (stand_pat + mg_value[QUEEN - 1] < alpha) {
+            return alpha;
+        }
     }
 
-    Move hashMove = NULL_MOVE;
+    PackedMove hashMove = NULL_PACKED_MOVE;
     int positionScore = 0;
-    if (getTransposition(board.hashCode, depth, ply, positionScore, alpha, beta, hashMove)) return positionScore;
-
-    std::vector<ScoredMove> moves = scoreTacticalMoves(MoveGenerator::tacticalMoves(board), hashMove);
+    SEARCH_STATS(stats.ttProbes++);
+    if (getTransposition(board.hashCode, depth, ply, positionScore, alpha, beta, hashMove)) {
+        SEARCH_STATS(stats.ttHits++);
+        SEARCH_STATS(stats.ttCutoffs++);
+        return positionScore;
+    }
+    SEARCH_STATS(stats.ttHits += hashMove != NULL_PACKED_MOVE);
 
     TranspositionTable::NodeType nodeType = TranspositionTable::UPPERBOUND;
     Move bestMove = {-1, -1, EMPTY, QUIET, WHITE};
     int bestScore = INT32_MIN;
 
-    for (int i = 0; i < moves.size(); i++) {
-        Move move = selectMove(moves, i);
+    if (inCheck) {
+        MoveList evasions;
+        MoveGenerator::evasionMoves(board, evasions);
+
+        bool hasLegalMoves = false;
+        for (const Move &move: evasions) {
+            if (move.flag == ENPASSANT) {
+                board.makeMove(move);
+                if (MoveGenerator::inCheck(board, invertColor(board.sideToMove))) {
+                    board.unMakeMove();
+                    continue;
+                }
+            } else {
+                if (!MoveGenerator::isLegal(board, move, legality)) continue;
+                board.makeMove(move);
+            }
+            hasLegalMoves = true;
 
-        board.makeMove(move);
-        if (MoveGenerator::inCheck(board, invertColor(board.sideToMove))) {
+            const int score = -quiesce(-beta, -alpha, ply + 1, depth - 1);
             board.unMakeMove();
-            continue;
+
+            if (stop) return 0;
+
+            if (score >= beta) {
+                tt.setEntry(board, move, depth, score, TranspositionTable::LOWERBOUND, ply);
+                return score;
+            }
+            if (score > alpha) {
+                alpha = score;
+                bestScore = score;
+                bestMove = move;
+                nodeType = TranspositionTable::EXACT;
+            } else if (score > bestScore) {
+                bestScore = score;
+                bestMove = move;
+            }
+        }
+        if (!hasLegalMoves) return -(MATE_SCORE - ply);
+
+        tt.setEntry(board, bestMove, depth, alpha, nodeType, ply);
+        return alpha;
+    }
+
+    MovePicker picker(board, hashMove);
+
+    for (Move move = picker.next(); move != NULL_MOVE; move = picker.next()) {
+        if (move.flag == ENPASSANT) {
+            board.makeMove(move);
+            if (MoveGenerator::inCheck(board, invertColor(board.sideToMove))) {
+                board.unMakeMove();
+                continue;
+            }
+        } else {
+            if (!MoveGenerator::isLegal(board, move, legality)) continue;
+            board.makeMove(move);
         }
 
         const int score = -quiesce(-beta, -alpha, ply + 1, depth - 1);
@@ -262,85 +627,17 @@ int Search::quiesce(int alpha, int beta, const int ply, const int depth) {
     return alpha;
 }
 
-std::vector<ScoredMove> Search::scoreMoves(const std::vector<Move> &moves, const int ply, const Move &hashMove) const {
-    std::vector<ScoredMove> scoredMoves;
-    for (const Move &move: moves) {
-        int score = 0;
-
-        if (move == hashMove) score = 1 << 30;
-
-        else if (move.promotionType != 0) {
-            score = mg_value[move.promotionType - 1] - mg_value[0];
-        } else if (move.flag == 0 || move.flag >= 7) {
-            if (move == killerMoves[ply][0] || move == killerMoves[ply][1])
-                score = 1 << 14;
-            else score = history[board.sideToMove][move.start][move.end];
-        } else {
-            if (move.flag == 6) score = 1 << 16;
-            else {
-                int captureScore = 0;
-                const int agressor = mg_value[board.squares[move.start].type - 1];
-                const int victim = mg_value[move.flag - 1];
-                captureScore += victim - agressor;
-                if (captureScore == 0) captureScore = 1;
-                if (captureScore > 0) captureScore <<= 16;
-                score += captureScore;
-            }
-        }
-
-        scoredMoves.push_back({move, score});
-    }
-    return scoredMoves;
-}
-
-std::vector<ScoredMove> Search::scoreTacticalMoves(const std::vector<Move> &moves, const Move &hashMove) const {
-    std::vector<ScoredMove> scoredMoves;
-
-    for (const Move &move: moves) {
-        int score;
-
-        if (move == hashMove) score = 1 << 30;
-        else {
-            if (move.promotionType != 0)
-                score = mg_value[move.promotionType - 1] - mg_value[0];
-            else
-                score = mg_value[move.flag - 1] -
-                        mg_value[board.squares[move.start].type - 1];
-        }
-
-        scoredMoves.push_back({move, score});
-    }
-    return scoredMoves;
-}
-
-Move Search::selectMove(std::vector<ScoredMove> &moves, const int index) {
-    int selectedIndex = index;
-    ScoredMove selected = moves[selectedIndex];
-    int maxScore = selected.score;
-
-    for (int i = index + 1; i < moves.size(); ++i) {
-        if (moves[i].score > maxScore) {
-            selectedIndex = i;
-            selected = moves[selectedIndex];
-            maxScore = selected.score;
-        }
-    }
-    moves[selectedIndex] = moves[index];
-    moves[index] = selected;
-
-    return selected.move;
-}
-
 void Search::storeKillerMove(const Move &move, const int ply) {
     if ((move.flag == 0 || move.flag >= 7) && move.promotionType == 0) {
-        if (killerMoves[ply][0] == move) return;
-        if (killerMoves[ply][1] == move) return;
+        const PackedMove packed = PackedMove::pack(move);
+        if (killerMoves[ply][0] == packed) return;
+        if (killerMoves[ply][1] == packed) return;
 
-        if (killerMoveIndexOne || killerMoves[ply][0] == NULL_MOVE) {
-            killerMoves[ply][0] = move;
+        if (killerMoveIndexOne || killerMoves[ply][0] == NULL_PACKED_MOVE) {
+            killerMoves[ply][0] = packed;
             killerMoveIndexOne = false;
         } else {
-            killerMoves[ply][1] = move;
+            killerMoves[ply][1] = packed;
             killerMoveIndexOne = true;
         }
     }
@@ -349,51 +646,27 @@ void Search::storeKillerMove(const Move &move, const int ply) {
 Search::Search(ChessBoard &board) : board(board) {
 }
 
-std::vector<Move> Search::collectPV(const int depth, bool &endEarly) const {
+std::vector<Move> Search::collectPV(bool &endEarly) const {
     std::vector<Move> pv;
-    std::unordered_set<uint64_t> pvPositions;
-    std::vector<int> scores;
-    pv.reserve(depth);
+    pv.reserve(pvLength[0]);
+    // the packed line is inflated by replaying it, every expansion needs the
+    // position the move is played from
+    for (int i = 0; i < pvLength[0]; ++i) {
+        pv.push_back(board.expandMove(pvTable[0][i]));
+        board.makeMove(pv.back());
+    }
+    for (int i = 0; i < pvLength[0]; ++i) board.unMakeMove();
 
-    int pvDepth = 0;
-    while (tt.contains(board.hashCode)) {
+    if (tt.contains(board.hashCode)) {
         const TranspositionTable::Entry entry = tt.getEntry(board.hashCode, 0);
-        if ((entry.nodeType != TranspositionTable::EXACT && entry.nodeType != TranspositionTable::BOOK) ||
-            entry.depth < 1)
-            break;
-        Move move = entry.bestMove;
-
-        if (TranspositionTable::isMateScore(entry.score) || entry.nodeType == TranspositionTable::BOOK)
+        if (entry.nodeType == TranspositionTable::BOOK) {
+            // book positions are never searched, take the stored move directly
+            pv.clear();
+            pv.push_back(board.expandMove(entry.bestMove));
             endEarly = true;
-#ifdef DEBUG
-        auto moves = MoveGenerator::pseudoLegalMoves(board);
-        if (moves.empty()) break;
-        bool legal = false;
-        for (const Move&m: moves) {
-            if (m == move) {
-                legal = true;
-                break;
-            }
-        }
-        if (legal) legal = MoveGenerator::isLegalMove(board, move);
-        if (!legal) {
-            std::cout << "Illegal move in PV! - " << Util::positionToString(move.start) <<
-                    Util::positionToString(move.end) << " " << move.flag << " Entry depth: " << entry.depth << " FEN: " << board.fen() << " Hashes: " << board.
-                    hashCode << std::endl;
-            break;
-        }
-#endif
-        pvPositions.insert(board.hashCode);
-        board.makeMove(move);
-        pv.push_back(move);
-        scores.push_back(entry.score);
-        pvDepth++;
-
-        if (pvPositions.contains(board.hashCode)) {
-            std::cout << "Cycle in PV!" << std::endl;
-            break;
-        }
+        } else if (TranspositionTable::isMateScore(entry.score)) endEarly = true;
     }
+
     std::string pvString;
     for (auto move: pv) {
         pvString += move.toString() + " ";
@@ -401,24 +674,89 @@ std::vector<Move> Search::collectPV(const int depth, bool &endEarly) const {
     logger.log("info PV " + pvString + "\n");
     logger.sendString("updatePV", pvString);
 
-    for (; pvDepth > 0; --pvDepth) {
-        board.unMakeMove();
+    return pv;
+}
+
+void Search::logMultiPVLine(const int depth, const int index, const int score) const {
+    std::string scoreString;
+    if (TranspositionTable::isMateScore(score)) {
+        const int pliesToMate = MATE_SCORE - std::abs(score);
+        const int movesToMate = (pliesToMate + 1) / 2;
+        scoreString = std::format("mate {}", score > 0 ? movesToMate : -movesToMate);
+    } else {
+        // internal scores are centipawns scaled by ten
+        scoreString = std::format("cp {}", score / 10);
     }
 
-    return pv;
+    std::string pvString;
+    for (int i = 0; i < pvLength[0]; ++i) pvString += pvTable[0][i].toString() + " ";
+    if (!pvString.empty()) pvString.pop_back();
+
+    logger.log(std::format("info depth {} multipv {} score {} pv {}\n", depth, index, scoreString, pvString));
 }
 
-std::vector<Move> Search::collectPV(int depth) const {
+std::vector<Move> Search::collectPV() const {
     bool unused = false;
-    return collectPV(depth, unused);
+    return collectPV(unused);
+}
+
+#ifdef searchstats
+void Search::logIterationStats(const int depth) {
+    const uint64_t iterationNodes = nodesSearched - statsIterationStart;
+    const double branchingFactor = statsPreviousIteration > 0
+                                       ? (double) iterationNodes / (double) statsPreviousIteration
+                                       : 0.0;
+    logger.log(std::format("info string depth {} nodes {} ebf {:.2f}\n", depth, iterationNodes, branchingFactor));
+    statsPreviousIteration = iterationNodes;
 }
 
+// human-readable summary plus one JSON line, both as info strings so any UCI
+// front end passes them through untouched
+void Search::reportStats() {
+    const uint64_t nodes = stats.mainNodes + stats.quiesceNodes;
+    if (nodes == 0) return;
+
+    logger.log(std::format("info string nodes {} main {} quiesce {} ({:.1f}%)\n",
+                           nodes, stats.mainNodes, stats.quiesceNodes, 100.0 * stats.quiesceNodes / nodes));
+    logger.log(std::format("info string node types pv {} cut {} all {}\n",
+                           stats.pvNodes, stats.cutNodes, stats.allNodes));
+
+    std::string histogram;
+    for (const uint64_t count: stats.cutoffIndex)
+        histogram += std::format("{:.1f} ", stats.cutNodes > 0 ? 100.0 * count / stats.cutNodes : 0.0);
+    histogram.pop_back();
+    logger.log(std::format("info string cutoff move index % [{}]\n", histogram));
+
+    logger.log(std::format("info string lmr searches {} re-searches {} ({:.1f}%)\n",
+                           stats.lmrSearches, stats.lmrReSearches,
+                           stats.lmrSearches > 0 ? 100.0 * stats.lmrReSearches / stats.lmrSearches : 0.0));
+    logger.log(std::format("info string tt probes {} hits {} ({:.1f}%) cutoffs {}\n",
+                           stats.ttProbes, stats.ttHits,
+                           stats.ttProbes > 0 ? 100.0 * stats.ttHits / stats.ttProbes : 0.0,
+                           stats.ttCutoffs));
+
+    std::string cutoffs;
+    for (const uint64_t count: stats.cutoffIndex) cutoffs += std::format("{},", count);
+    cutoffs.pop_back();
+    logger.log(std::format(
+        R"(info string stats {{"mainNodes":{},"quiesceNodes":{},"pvNodes":{},"cutNodes":{},"allNodes":{},)"
+        R"("cutoffIndex":[{}],"lmrSearches":{},"lmrReSearches":{},"ttProbes":{},"ttHits":{},"ttCutoffs":{}}})"
+        "\n",
+        stats.mainNodes, stats.quiesceNodes, stats.pvNodes, stats.cutNodes, stats.allNodes, cutoffs,
+        stats.lmrSearches, stats.lmrReSearches, stats.ttProbes, stats.ttHits, stats.ttCutoffs));
+}
+#endif
+
 
 bool Search::getTransposition(const uint64_t hash, const int depth, const int ply, int &score, const int &alpha,
-                              const int &beta, Move &hashMove) {
+                              const int &beta, PackedMove &hashMove) {
     if (tt.contains(hash)) {
         const TranspositionTable::Entry entry = tt.getEntry(hash, ply);
 
+        // hand the stored move out even on a score cutoff, so a caller that
+        // declines the cutoff still gets its ordering hint
+        hashMove = entry.bestMove;
+
         if (entry.nodeType == TranspositionTable::BOOK) {
             score = entry.score;
             return true;
@@ -444,7 +782,6 @@ bool Search::getTransposition(const uint64_t hash, const int depth, const int pl
                     break;
             }
         }
-        hashMove = entry.bestMove;
     }
 
     return false;
@@ -453,7 +790,18 @@ bool Search::getTransposition(const uint64_t hash, const int depth, const int pl
 void Search::reset() {
     stop = false;
     lastPV.clear();
-    killerMoves = std::array<std::array<Move, 2>, 64>();
+    excludedRootMoves.clear();
+    SEARCH_STATS(stats.reset());
+    SEARCH_STATS(statsPreviousIteration = 0);
+    killerMoves = std::array<std::array<PackedMove, 2>, 64>();
     killerMoveIndexOne = false;
-    history = std::array<std::array<std::array<int, 64>, 64>, 2>();
+    // age rather than forget: halved scores from the previous search still
+    // order moves until fresher signals overtake them
+    for (auto &side: history)
+        for (auto &from: side)
+            for (auto &entry: from) entry /= 2;
+    for (auto &prevPiece: continuationHistory)
+        for (auto &prevTo: prevPiece)
+            for (auto &piece: prevTo)
+                for (auto &entry: piece) entry /= 2;
 }
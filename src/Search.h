@@ -3,25 +3,33 @@
 
 #include "Move.h"
 #include "ChessBoard.h"
+#include "MovePicker.h"
 #include "TranspositionTable.h"
 #include <array>
 #include <atomic>
+#include <chrono>
 #include <condition_variable>
 #include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <thread>
+#include <vector>
 
 #include "Logger.h"
+#include "SearchStats.h"
 
 using namespace Moves;
 
-struct ScoredMove {
-	Move move;
-	int score;
-};
-
 class Search {
 public:
 	ChessBoard&board;
 	static TranspositionTable tt;
+	// number of search threads (1 = the single master thread), set via
+	// "setoption name Threads value N"
+	static int threadCount;
+	// number of principal variations reported per iteration (1 = normal
+	// search), set via "setoption name MultiPV value N"
+	static int multiPV;
 
 	explicit Search(ChessBoard&board);
 
@@ -29,15 +37,83 @@ public:
 
     Move endSearch(int timeOut);
 
+	// raises the stop flag from outside the search threads, cutting short a
+	// blocked endSearch; waits for depth one first so there is always a move
+	// to report. Harmless when no search is running - reset() clears the flag
+	void interrupt();
+
+	// what a batch analysis search concluded about one position
+	struct AnalysisResult {
+		Move bestMove;
+		int score;
+		int depth;
+		uint64_t nodes;
+	};
+
+	// synchronous iterative deepening to a fixed depth and/or node budget
+	// (0 = unlimited), without helper threads or semaphores - made for the
+	// analyzefile batch mode where positions stream through one Search
+	AnalysisResult analyze(int targetDepth, uint64_t nodeBudget);
+
+	// limits for the next timed search, all 0 = unlimited: depth caps the
+	// iterative deepening loop, nodes budgets the tree, the soft time limit
+	// skips an iteration that is unlikely to finish and the hard one cuts the
+	// search mid-tree
+	void setLimits(int depth, uint64_t nodes, int64_t softTimeMs, int64_t hardTimeMs);
+
+	// predicted reply from the last finished search, for pondering
+	Move ponderMove() const { return lastPV.size() > 1 ? lastPV[1] : NULL_MOVE; }
+
+	// nodes visited by this thread since the limits were last set
+	uint64_t nodes() const { return nodesSearched; }
+
     void reset();
 
 private:
-	std::array<std::array<Move, 2>, 64> killerMoves{};
+	struct Helper;
+
+	static constexpr int MAX_PLY = 96;
+
+	std::vector<std::unique_ptr<Helper>> helpers;
+	std::vector<std::thread> helperThreads;
+	// triangular PV table: row ply holds the best line found at that ply,
+	// copied up one row whenever a move improves alpha. Stored packed, and
+	// collectPV inflates the line by replaying it
+	std::array<std::array<PackedMove, MAX_PLY>, MAX_PLY> pvTable{};
+	std::array<int, MAX_PLY> pvLength{};
+	std::array<std::array<PackedMove, 2>, 64> killerMoves{};
 	bool killerMoveIndexOne = false;
-	std::array<std::array<std::array<int, 64>, 64>, 2> history{};
+	HistoryTable history{};
+	CounterMoveTable counterMoves{};
+	ContinuationTable continuationHistory{};
 	std::vector<Move> lastPV;
+	// root moves already reported as better lines this iteration, skipped so
+	// the next search settles on the next best alternative
+	std::vector<PackedMove> excludedRootMoves;
+
+	std::atomic<bool> stop = false;
+
+#ifdef searchstats
+	SearchStats stats;
+	// nodes at the start of the running iteration and the size of the
+	// previous one, for the per-iteration branching factor line
+	uint64_t statsIterationStart = 0;
+	uint64_t statsPreviousIteration = 0;
+
+	void logIterationStats(int depth);
 
-	bool stop = false;
+	void reportStats();
+#endif
+
+	// nodes visited since the last reset, compared against nodeLimit (0 =
+	// none) to cut off budgeted searches
+	uint64_t nodesSearched = 0;
+	uint64_t nodeLimit = 0;
+
+	std::chrono::steady_clock::time_point searchStart;
+	int64_t softTimeLimit = 0;
+	int64_t hardTimeLimit = 0;
+	int depthLimit = 0;
 
     std::binary_semaphore searchingSemaphore{1};
     std::binary_semaphore reachedDepthOneSemaphore{1};
@@ -46,22 +122,42 @@ private:
 
 	void threadedSearch();
 
-	int alphaBeta(int depth, int alpha, int beta, int ply);
+	void logMultiPVLine(int depth, int index, int score) const;
 
-	int quiesce(int alpha, int beta, int ply, int depth);
+	void startHelpers();
+
+	void stopHelpers();
 
-	std::vector<ScoredMove> scoreMoves(const std::vector<Move>&moves, int ply, const Move&hashMove) const;
+	void helperLoop(int helperIndex);
 
-	std::vector<ScoredMove> scoreTacticalMoves(const std::vector<Move>&moves, const Move&hashMove) const;
+	int alphaBeta(int depth, int alpha, int beta, int ply, bool nullAllowed = true);
 
-	static bool getTransposition(uint64_t hash, int depth, int ply, int&score, const int&alpha, const int&beta, Move&hashMove);
+	int quiesce(int alpha, int beta, int ply, int depth);
 
-	static Move selectMove(std::vector<ScoredMove>&moves, int index);
+	static bool getTransposition(uint64_t hash, int depth, int ply, int&score, const int&alpha, const int&beta, PackedMove&hashMove);
 
 	void storeKillerMove(const Move&move, int ply);
 
-    std::vector<Move> collectPV(int depth) const;
-	std::vector<Move> collectPV(int depth, bool& endEarly) const;
+	// gravity update: entries saturate towards +-MAX_HISTORY instead of
+	// growing without bound, so fresh signals can still shift the order
+	static constexpr int MAX_HISTORY = 16384;
+
+	static void applyHistoryGravity(int&entry, int bonus) {
+		entry += bonus - entry * std::abs(bonus) / MAX_HISTORY;
+	}
+
+    std::vector<Move> collectPV() const;
+	std::vector<Move> collectPV(bool& endEarly) const;
+};
+
+// a Lazy SMP helper: its own board copy and search state, sharing only the
+// transposition table with the master thread
+struct Search::Helper {
+	ChessBoard board;
+	Search search;
+
+	explicit Helper(const ChessBoard&position) : board(position), search(board) {
+	}
 };
 
 #endif
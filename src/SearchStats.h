@@ -0,0 +1,53 @@
+#ifndef CHESSENGINE_SEARCHSTATS_H
+#define CHESSENGINE_SEARCHSTATS_H
+
+#include <array>
+#include <cstdint>
+
+// Per-thread search counters, opt-in at compile time like the search trace:
+// without the flag the macro expands to nothing and the hot paths carry no
+// counting code at all. Every Search instance (master and each Lazy SMP
+// helper) owns one cache-line-aligned block, so the increments never contend
+// or false-share; the master folds the helper blocks in when a search ends.
+#ifdef searchstats
+struct alignas(64) SearchStats {
+	// nodes by type
+	uint64_t mainNodes = 0;
+	uint64_t quiesceNodes = 0;
+	uint64_t pvNodes = 0; //closed with an exact score
+	uint64_t cutNodes = 0; //failed high
+	uint64_t allNodes = 0; //failed low
+	// which move (by picker order) produced the beta cutoff, the last bucket
+	// collects everything from the eighth move on
+	std::array<uint64_t, 8> cutoffIndex{};
+	// reduced zero-window scouts, and how many failed high and had to be
+	// re-searched at full depth
+	uint64_t lmrSearches = 0;
+	uint64_t lmrReSearches = 0;
+	uint64_t ttProbes = 0;
+	uint64_t ttHits = 0; //entry found, usable at least for ordering
+	uint64_t ttCutoffs = 0; //entry ended the node outright
+
+	void add(const SearchStats&other) {
+		mainNodes += other.mainNodes;
+		quiesceNodes += other.quiesceNodes;
+		pvNodes += other.pvNodes;
+		cutNodes += other.cutNodes;
+		allNodes += other.allNodes;
+		for (size_t i = 0; i < cutoffIndex.size(); ++i) cutoffIndex[i] += other.cutoffIndex[i];
+		lmrSearches += other.lmrSearches;
+		lmrReSearches += other.lmrReSearches;
+		ttProbes += other.ttProbes;
+		ttHits += other.ttHits;
+		ttCutoffs += other.ttCutoffs;
+	}
+
+	void reset() { *this = SearchStats(); }
+};
+
+#define SEARCH_STATS(statement) statement
+#else
+#define SEARCH_STATS(statement) ((void)0)
+#endif
+
+#endif //CHESSENGINE_SEARCHSTATS_H
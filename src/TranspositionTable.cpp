@@ -1,63 +1,142 @@
 #include "TranspositionTable.h"
 #include <cmath>
-#include <fstream>
-
-#include "MoveParser.h"
 
 #define MATE_SCORE INT32_MAX
 #define MIN_MATE_SCORE (INT32_MAX - 1024)
 
+TranspositionTable::TranspositionTable() {
+    resize(256);
+}
+
+void TranspositionTable::resize(const int megabytes) {
+    const size_t bucketCount = static_cast<size_t>(megabytes) * 1024 * 1024 / sizeof(Bucket);
+    buckets = std::vector<Bucket>(std::max<size_t>(bucketCount, 1));
+    resetCounters();
+    entryCount = 0;
+    generation = 0;
+}
+
+void TranspositionTable::newSearch() {
+    generation = (generation + 1) & 0x3;
+}
+
+uint64_t TranspositionTable::pack(const Move bestMove, int depth, const int32_t score, const NodeType nodeType,
+                                  const uint8_t generation) {
+    if (depth < -64) depth = -64;
+
+    return (static_cast<uint64_t>(generation) & 0x3) |
+           ((static_cast<uint64_t>(nodeType) & 0x7) << 2) |
+           ((static_cast<uint64_t>(depth + 64) & 0x7F) << 5) |
+           (static_cast<uint64_t>(Moves::PackedMove::pack(bestMove).bits) << 12) |
+           (static_cast<uint64_t>(static_cast<uint32_t>(score)) << 32);
+}
+
+TranspositionTable::Entry TranspositionTable::unpack(const uint64_t key, const uint64_t data) {
+    Entry entry{};
+    entry.key = key;
+    entry.nodeType = nodeTypeOf(data);
+    entry.depth = static_cast<int8_t>(depthOf(data));
+    entry.score = static_cast<int32_t>(data >> 32);
+
+    entry.bestMove = Moves::PackedMove(static_cast<uint16_t>((data >> 12) & 0xFFFF));
+
+    return entry;
+}
+
 TranspositionTable::Entry TranspositionTable::getEntry(const uint64_t key, const int ply) {
-    const int index = key % TT_SIZE;
-    Entry entry = entries[index];
+    Bucket &bucket = buckets[bucketIndex(key)];
+    reads++;
 
-    if (isMateScore(entry.score)) {
-        const int sign = entry.score > 0 ? 1 : -1;
-        entry.score = sign * (abs(entry.score) - ply);
+    for (PackedEntry &slot: bucket.slots) {
+        const uint64_t data = slot.data.load(std::memory_order_relaxed);
+        const uint64_t keyXorData = slot.keyXorData.load(std::memory_order_relaxed);
+        if ((keyXorData ^ data) != key || nodeTypeOf(data) == FREE) continue;
+
+        Entry entry = unpack(key, data);
+        if (isMateScore(entry.score)) {
+            const int sign = entry.score > 0 ? 1 : -1;
+            entry.score = sign * (abs(entry.score) - ply);
+        }
+        return entry;
     }
-    reads++;
 
-    return entry;
+    return Entry{};
 }
 
 bool TranspositionTable::contains(const uint64_t key) {
-    const int index = key % TT_SIZE;
-    const bool exists = entries[index].nodeType != FREE;
-    const bool sameKey = (entries[index].key == key);
-    if (exists && !sameKey) collisions++;
+    Bucket &bucket = buckets[bucketIndex(key)];
+
+    bool occupied = false;
+    for (PackedEntry &slot: bucket.slots) {
+        const uint64_t data = slot.data.load(std::memory_order_relaxed);
+        const uint64_t keyXorData = slot.keyXorData.load(std::memory_order_relaxed);
+        if (nodeTypeOf(data) == FREE) continue;
+        occupied = true;
+        if ((keyXorData ^ data) == key) return true;
+    }
+    if (occupied) collisions++;
 
-    return exists && sameKey;
+    return false;
 }
 
 void TranspositionTable::setEntry(const ChessBoard &board, const Move bestMove, const int depth, int score,
                                   const NodeType nodeType, const int ply) {
-    const int index = board.hashCode % TT_SIZE;
+    const uint64_t key = board.hashCode;
+    Bucket &bucket = buckets[bucketIndex(key)];
 
     if (isMateScore(score)) {
         const int sign = score > 0 ? 1 : -1;
         score = sign * (abs(score) + ply);
     }
 
-    const NodeType savedType = entries[index].nodeType;
+    const uint64_t packed = pack(bestMove, depth, score, nodeType, generation);
 
-    const Entry entry = {board.hashCode, bestMove, score, static_cast<int8_t>(depth), nodeType};
-
-    //REPLACEMENT SCHEME
+    // same position already stored: apply the depth/bound replacement rules
     // 1. Prefer EXACT nodes to bounds
     // 2. Prefer deeper nodes to shallower
+    for (PackedEntry &slot: bucket.slots) {
+        const uint64_t data = slot.data.load(std::memory_order_relaxed);
+        const uint64_t keyXorData = slot.keyXorData.load(std::memory_order_relaxed);
+        if (nodeTypeOf(data) == FREE || (keyXorData ^ data) != key) continue;
+
+        const NodeType savedType = nodeTypeOf(data);
+        bool replace;
+        if (savedType != BOOK) {
+            if ((savedType != EXACT && nodeType != EXACT) || (savedType == EXACT && nodeType == EXACT))
+                replace = depthOf(data) <= depth;
+            else replace = savedType != EXACT;
+        } else replace = nodeType == BOOK;
+
+        if (replace) {
+            slot.data.store(packed, std::memory_order_relaxed);
+            slot.keyXorData.store(key ^ packed, std::memory_order_relaxed);
+            writes++;
+        }
+        return;
+    }
 
-    if (savedType != FREE && savedType != BOOK) {
-        if ((savedType != EXACT && nodeType != EXACT) || (savedType == EXACT && nodeType == EXACT)) {
-            if (entries[index].depth <= depth) write(index, entry);
-        } else if (savedType != EXACT) write(index, entry);
-    } else {
-        entryCount++;
-        write(index, entry);
+    // new position: take a free slot, otherwise evict the least valuable one,
+    // preferring entries from older searches and shallower depths
+    PackedEntry *victim = nullptr;
+    int victimValue = INT32_MAX;
+    for (PackedEntry &slot: bucket.slots) {
+        const uint64_t data = slot.data.load(std::memory_order_relaxed);
+        if (nodeTypeOf(data) == FREE) {
+            victim = &slot;
+            entryCount++;
+            break;
+        }
+        const int age = (generation - generationOf(data)) & 0x3;
+        int value = depthOf(data) - 16 * age;
+        if (nodeTypeOf(data) == EXACT) value += 8;
+        if (value < victimValue) {
+            victimValue = value;
+            victim = &slot;
+        }
     }
-}
 
-void TranspositionTable::write(const int index, const Entry &entry) {
-    entries[index] = entry;
+    victim->data.store(packed, std::memory_order_relaxed);
+    victim->keyXorData.store(key ^ packed, std::memory_order_relaxed);
     writes++;
 }
 
@@ -70,37 +149,13 @@ void TranspositionTable::resetCounters() {
 void TranspositionTable::clear() {
     resetCounters();
     entryCount = 0;
-    for (Entry &entry: entries) {
-        entry.nodeType = FREE;
-    }
-}
-
-void TranspositionTable::loadOpenings(ChessBoard &board) {
-    std::ifstream file("opening_book.txt");
-
-    if (!file.is_open()) {
-        std::cerr << "Failed to open opening book" << std::endl;
-        return;
-    }
-
-    std::string line;
-    std::getline(file, line);
-    entries[board.hashCode % TT_SIZE] = {board.hashCode, parseMove(line,board), 0, 1, BOOK};
-
-    while (!file.eof()) {
-        std::getline(file, line);
-        if (line[0] == 'm') {
-            std::getline(file, line);
-            board.makeMove(parseMove(line, board));
-
-            std::getline(file, line);
-            entries[board.hashCode % TT_SIZE] = {board.hashCode, parseMove(line,board), 0, 1, BOOK};
-        } else if (line[0] == 'u'){
-            board.unMakeMove();
+    generation = 0;
+    for (Bucket &bucket: buckets) {
+        for (PackedEntry &slot: bucket.slots) {
+            slot.keyXorData.store(0, std::memory_order_relaxed);
+            slot.data.store(0, std::memory_order_relaxed);
         }
     }
-
-    file.close();
 }
 
 bool TranspositionTable::isMateScore(int32_t score) {
@@ -2,14 +2,16 @@
 #define CHESSENGINE_TRANSPOSITIONTABLE_H
 
 #include <array>
+#include <atomic>
+#include <vector>
 #include "Move.h"
 #include <cstdint>
 
 #include "ChessBoard.h"
 
-// 256 megabytes
-#define TT_SIZE (1<<23)
-
+// Shared between all search threads. Entries are packed into a single 64-bit
+// data word stored next to key^data, so a probe validates the pair with one
+// XOR and torn writes are simply rejected - no locks anywhere.
 class TranspositionTable {
 public:
     enum NodeType {
@@ -19,39 +21,69 @@ public:
         UPPERBOUND = 3,
         BOOK = 4
     };
+
+    // unpacked view of a stored position, as handed to the search. The best
+    // move stays in its 16-bit storage form, the search expands it against
+    // the probing position
     struct Entry {
-        uint64_t key: 64;
-        Move bestMove;
-        int32_t score: 32;
-        int8_t depth: 8;
-        NodeType nodeType: 3;
+        uint64_t key;
+        Moves::PackedMove bestMove;
+        int32_t score;
+        int8_t depth;
+        NodeType nodeType;
     };
 
+    TranspositionTable();
+
+    // size the table to the given number of megabytes, dropping all entries
+    void resize(int megabytes);
+
+    // age the table by one search, used by the replacement scheme
+    void newSearch();
+
     bool contains(uint64_t key);
 
     Entry getEntry(uint64_t key, int ply);
 
     void setEntry(const ChessBoard &board, Move bestMove, int depth, int score, NodeType nodeType, int ply);
 
-    static bool isMateScore(int32_t score) ;
+    static bool isMateScore(int32_t score);
 
-    int reads = 0;
-    int writes = 0;
-    int collisions = 0;
-    int entryCount = 0;
+    std::atomic<int> reads = 0;
+    std::atomic<int> writes = 0;
+    std::atomic<int> collisions = 0;
+    std::atomic<int> entryCount = 0;
 
     void resetCounters();
 
     void clear();
 
-    void loadOpenings(ChessBoard &board);
+private:
+    // score(32) | move(16) | depth+64(7) | nodeType(3) | generation(2)
+    struct PackedEntry {
+        std::atomic<uint64_t> keyXorData;
+        std::atomic<uint64_t> data;
+    };
 
-    std::array<Entry, TT_SIZE> entries{};
+    // four entries sharing one cache line
+    struct alignas(64) Bucket {
+        std::array<PackedEntry, 4> slots;
+    };
 
-private:
-    void write(int index, const Entry &entry);
+    std::vector<Bucket> buckets;
+    uint8_t generation = 0;
+
+    size_t bucketIndex(const uint64_t key) const { return key % buckets.size(); }
+
+    static uint64_t pack(Move bestMove, int depth, int32_t score, NodeType nodeType, uint8_t generation);
+
+    static Entry unpack(uint64_t key, uint64_t data);
+
+    static uint8_t generationOf(const uint64_t data) { return data & 0x3; }
 
+    static NodeType nodeTypeOf(const uint64_t data) { return static_cast<NodeType>((data >> 2) & 0x7); }
 
+    static int depthOf(const uint64_t data) { return static_cast<int>((data >> 5) & 0x7F) - 64; }
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,123 @@
+#include "ChessBoard.h"
+#include "MoveGenerator.h"
+#include "Search.h"
+
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Throughput regression suite, run as a CTest target. Phase one verifies the
+// standard perft positions and reports nodes per second, phase two runs a
+// fixed-budget search over ~50 positions derived from the same bases with a
+// stable seed and reports transposition table behaviour. Compare the summary
+// lines between releases.
+
+namespace {
+	struct PerftCase {
+		const char* fen;
+		int depth;
+		uint64_t nodes;
+	};
+
+	constexpr PerftCase perftCases[] = {
+		{"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1", 5, 4865609ULL},
+		{"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1", 4, 4085603ULL},
+		{"8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1", 5, 674624ULL},
+		{"r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1", 4, 422333ULL},
+		{"rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8", 4, 2103487ULL},
+		{"r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10", 4, 3894594ULL},
+	};
+
+	constexpr int SEARCH_MOVETIME_MS = 100;
+
+	// plays a fixed number of seeded random legal moves from a base position,
+	// so the search set is stable across runs and releases
+	std::string derivePosition(const char* baseFen, const int plies, const uint64_t seed) {
+		std::mt19937_64 rng(seed);
+		ChessBoard board;
+		board.setPosition(baseFen);
+		for (int i = 0; i < plies; ++i) {
+			MoveList moves;
+			MoveGenerator::pseudoLegalMoves(board, moves);
+			MoveList legal;
+			for (const Move& move: moves) {
+				if (MoveGenerator::isLegalMove(board, move)) legal.push_back(move);
+			}
+			if (legal.empty()) break;
+			board.makeMove(legal[rng() % legal.size()]);
+		}
+		return board.fen();
+	}
+}
+
+int main() {
+	uint64_t totalNodes = 0;
+	double totalSeconds = 0.0;
+	bool failed = false;
+
+	printf("=== perft ===\n");
+	for (const PerftCase& testCase: perftCases) {
+		ChessBoard board;
+		board.setPosition(testCase.fen);
+
+		const auto start = std::chrono::steady_clock::now();
+		const uint64_t nodes = MoveGenerator::perft(testCase.depth, board);
+		const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+		totalNodes += nodes;
+		totalSeconds += seconds;
+
+		if (nodes != testCase.nodes) {
+			printf("FAIL depth %d %s: %llu nodes, expected %llu\n", testCase.depth, testCase.fen,
+			       (unsigned long long) nodes, (unsigned long long) testCase.nodes);
+			failed = true;
+			continue;
+		}
+		printf("depth %d %-72s %9llu nodes %7.1f ms %6.2f Mnps\n", testCase.depth, testCase.fen,
+		       (unsigned long long) nodes, seconds * 1000.0, nodes / seconds / 1e6);
+	}
+	printf("perft total: %llu nodes in %.1f ms -> %.2f Mnps\n\n",
+	       (unsigned long long) totalNodes, totalSeconds * 1000.0, totalNodes / totalSeconds / 1e6);
+
+	std::vector<std::string> fens;
+	fens.emplace_back(perftCases[0].fen);
+	fens.emplace_back(perftCases[1].fen);
+	for (const PerftCase& testCase: perftCases) {
+		for (int plies = 2; plies <= 16; plies += 2) {
+			fens.push_back(derivePosition(testCase.fen, plies, 0x5eed + plies));
+		}
+	}
+
+	printf("=== search (%zu positions x %d ms) ===\n", fens.size(), SEARCH_MOVETIME_MS);
+	long long reads = 0, writes = 0, collisions = 0;
+	uint64_t searchNodes = 0;
+	const auto searchStart = std::chrono::steady_clock::now();
+	for (const std::string& fen: fens) {
+		ChessBoard board;
+		board.setPosition(fen);
+		Search search(board);
+
+		Search::tt.clear();
+		search.reset();
+		search.doSearch();
+		std::this_thread::sleep_for(std::chrono::milliseconds(SEARCH_MOVETIME_MS));
+		// counters are reset inside endSearch, snapshot them while stopping
+		reads += Search::tt.reads.load();
+		writes += Search::tt.writes.load();
+		collisions += Search::tt.collisions.load();
+		search.endSearch(0);
+		searchNodes += search.nodes();
+	}
+	const double searchSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - searchStart).count();
+
+	const long long probes = reads + collisions;
+	printf("search total: %llu nodes in %.1f s -> %.2f Mnps\n",
+	       (unsigned long long) searchNodes, searchSeconds, searchNodes / searchSeconds / 1e6);
+	printf("search TT: reads %lld, writes %lld, collisions %lld, hit rate %.1f%%\n",
+	       reads, writes, collisions, probes > 0 ? 100.0 * reads / probes : 0.0);
+
+	return failed ? 1 : 0;
+}
@@ -0,0 +1,69 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "ChessBoard.h"
+#include "Endgame.h"
+
+// init returns once the tables are generated, repeated calls are free
+static void buildTables() {
+	Endgame::init();
+}
+
+TEST_CASE("Endgame - KQvK is a win for the strong side", "[EndgameTests]") {
+	buildTables();
+	ChessBoard board = ChessBoard();
+	board.setPosition("8/8/8/4k3/8/8/3Q4/4K3 w - - 0 1");
+	int score = 0;
+	CHECK(Endgame::probe(board, score));
+	CHECK(score > Endgame::WIN_SCORE - 100);
+
+	// in check with the defender to move, still lost for him
+	board.setPosition("8/8/8/4k3/8/8/4Q3/4K3 b - - 0 1");
+	CHECK(Endgame::probe(board, score));
+	CHECK(score < -(Endgame::WIN_SCORE - 100));
+}
+
+TEST_CASE("Endgame - KRvK mirrored for a strong black side", "[EndgameTests]") {
+	buildTables();
+	ChessBoard board = ChessBoard();
+	board.setPosition("4k3/3r4/8/8/8/8/8/4K3 b - - 0 1");
+	int score = 0;
+	CHECK(Endgame::probe(board, score));
+	CHECK(score > Endgame::WIN_SCORE - 100);
+}
+
+TEST_CASE("Endgame - lone minors are dead draws", "[EndgameTests]") {
+	buildTables();
+	ChessBoard board = ChessBoard();
+	board.setPosition("8/8/8/4k3/8/8/4B3/4K3 w - - 0 1");
+	int score = -1;
+	CHECK(Endgame::probe(board, score));
+	CHECK(score == 0);
+
+	board.setPosition("8/8/8/4k3/8/8/4N3/4K3 b - - 0 1");
+	score = -1;
+	CHECK(Endgame::probe(board, score));
+	CHECK(score == 0);
+}
+
+TEST_CASE("Endgame - KPvK knows the difference between win and draw", "[EndgameTests]") {
+	buildTables();
+	ChessBoard board = ChessBoard();
+	// king in front of the pawn with the opposition, winning
+	board.setPosition("4k3/8/4K3/4P3/8/8/8/8 w - - 0 1");
+	int score = 0;
+	CHECK(Endgame::probe(board, score));
+	CHECK(score > Endgame::WIN_SCORE - 100);
+
+	// rook pawn with the defending king in the corner, drawn
+	board.setPosition("k7/8/1K6/P7/8/8/8/8 w - - 0 1");
+	CHECK(Endgame::probe(board, score));
+	CHECK(score == 0);
+}
+
+TEST_CASE("Endgame - positions with more than three men miss", "[EndgameTests]") {
+	buildTables();
+	ChessBoard board = ChessBoard();
+	board.setPosition("8/8/8/4k3/8/8/3QQ3/4K3 w - - 0 1");
+	int score = 0;
+	CHECK(!Endgame::probe(board, score));
+}
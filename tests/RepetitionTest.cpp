@@ -75,34 +75,46 @@ TEST_CASE("Repetitions - after irreversible move", "[RepetitionTests]") {
 	CHECK(board.isDraw());
 }
 
+TEST_CASE("Repetitions - forgotten after unmake", "[RepetitionTests]") {
+	ChessBoard board = ChessBoard();
+	board.setPosition("2r2rk1/1q1b1pp1/2nppn1p/3p4/N2P1N1P/4PB2/1P1Q1PP1/2R1R1K1 b - - 6 23");
+	board.makeMove(parseMove("f6e4", board));
+	board.makeMove(parseMove("d2d1", board));
+	board.makeMove(parseMove("e4f6", board));
+	board.makeMove(parseMove("d1d2", board));
+	CHECK(board.isDraw());
+	board.unMakeMove();
+	CHECK(!board.isDraw());
+	board.makeMove(parseMove("d1d2", board));
+	CHECK(board.isDraw());
+}
+
 TEST_CASE("Repetitions - Irreversible Moves", "[RepetitionTests]") {
 	ChessBoard board = ChessBoard();
 	board.setPosition("2r2rk1/1q1b1pp1/2nppn1p/3p4/N2P1N1P/4PB2/1P3PP1/2RQR1K1 w - - 5 23");
 	CHECK(!board.isDraw());
-	CHECK(board.irreversibleIndices.empty());
-	CHECK(board.positionHistory.empty());
+	CHECK(board.plyCount == 0);
+	CHECK(board.lastIrreversiblePly == -1);
 	// PAWN move
 	board.makeMove(parseMove("b2b4", board));
-	CHECK(board.positionHistory.size() == 1);
-	CHECK(board.irreversibleIndices.size() == 1);
-	CHECK(board.irreversibleIndices[0] == 0);
+	CHECK(board.plyCount == 1);
+	CHECK(board.lastIrreversiblePly == 0);
 	// CAPTURE
 	board.makeMove(parseMove("c6b4", board));
-	CHECK(board.positionHistory.size() == 2);
-	CHECK(board.irreversibleIndices.size() == 2);
-	CHECK(board.irreversibleIndices[1] == 1);
+	CHECK(board.plyCount == 2);
+	CHECK(board.lastIrreversiblePly == 1);
 	// QUIET MOVE
 	board.makeMove(parseMove("a4c3", board));
-	CHECK(board.positionHistory.size() == 3);
-	CHECK(board.irreversibleIndices.size() == 2);
+	CHECK(board.plyCount == 3);
+	CHECK(board.lastIrreversiblePly == 1);
 	board.unMakeMove();
-	CHECK(board.positionHistory.size() == 2);
-	CHECK(board.irreversibleIndices.size() == 2);
+	CHECK(board.plyCount == 2);
+	CHECK(board.lastIrreversiblePly == 1);
 	board.unMakeMove();
-	CHECK(board.positionHistory.size() == 1);
-	CHECK(board.irreversibleIndices.size() == 1);
+	CHECK(board.plyCount == 1);
+	CHECK(board.lastIrreversiblePly == 0);
 	board.unMakeMove();
-	CHECK(board.positionHistory.empty());
-	CHECK(board.irreversibleIndices.empty());
+	CHECK(board.plyCount == 0);
+	CHECK(board.lastIrreversiblePly == -1);
 	CHECK(board.fen() == "2r2rk1/1q1b1pp1/2nppn1p/3p4/N2P1N1P/4PB2/1P3PP1/2RQR1K1 w - - 5 23");
 }
\ No newline at end of file
@@ -0,0 +1,34 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "ChessBoard.h"
+#include "MoveParser.h"
+
+TEST_CASE("SEE - free pawn", "[SeeTests]") {
+	ChessBoard board;
+	board.setPosition("1k6/8/8/4p3/3P4/8/8/4K3 w - - 0 1");
+	CHECK(board.see(parseMove("d4e5", board)) == 820);
+}
+
+TEST_CASE("SEE - defended pawn", "[SeeTests]") {
+	ChessBoard board;
+	board.setPosition("1k6/8/3p4/4p3/8/3N4/8/4K3 w - - 0 1");
+	CHECK(board.see(parseMove("d3e5", board)) == 820 - 3370);
+}
+
+TEST_CASE("SEE - queen takes defended rook", "[SeeTests]") {
+	ChessBoard board;
+	board.setPosition("1k6/2p5/3r4/8/8/8/3Q4/3K4 w - - 0 1");
+	CHECK(board.see(parseMove("d2d6", board)) == 4770 - 10250);
+}
+
+TEST_CASE("SEE - rook battery x-ray", "[SeeTests]") {
+	ChessBoard board;
+	board.setPosition("1k2r3/8/8/4r3/8/8/4R3/2K1R3 w - - 0 1");
+	CHECK(board.see(parseMove("e2e5", board)) == 4770);
+}
+
+TEST_CASE("SEE - even rook trade", "[SeeTests]") {
+	ChessBoard board;
+	board.setPosition("1k2r3/8/8/4r3/8/8/4R3/4K3 w - - 0 1");
+	CHECK(board.see(parseMove("e2e5", board)) == 0);
+}
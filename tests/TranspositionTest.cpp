@@ -14,7 +14,7 @@ TEST_CASE("TT - rw", "[TranspositionTests]") {
 	board.setPosition("8/RP1qb1B1/2p2P2/6n1/P7/p3k3/Q3b1BK/6R1 w - - 0 1");
 	tt.setEntry(board, parseMove("f6e7", board), 1, 1, TranspositionTable::EXACT, 1);
 	const auto readEntry = tt.getEntry(board.hashCode, 1);
-	CHECK(readEntry.bestMove == parseMove("f6e7", board));
+	CHECK(board.expandMove(readEntry.bestMove) == parseMove("f6e7", board));
 	CHECK(readEntry.depth == 1);
 	CHECK(readEntry.score == 1);
 	CHECK(readEntry.nodeType == TranspositionTable::EXACT);
@@ -0,0 +1,348 @@
+#include "ChessBoard.h"
+#include "Evaluator.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Texel-style evaluation tuner, built next to the benchmark as an offline
+// tool. "tuner convert games.txt corpus.bin" packs a text corpus of
+// "FEN result" lines into fixed-size feature records, then
+// "tuner corpus.bin [iterations N] [lr X] [k K] [threads T] [output F]"
+// memory-maps the records and runs full-batch gradient descent on the
+// piece-square tables and pawn structure terms, minimizing the squared error
+// between the sigmoid of the static evaluation and the game results. Each
+// iteration streams the corpus in contiguous per-thread chunks, so a
+// multi-million position corpus is bounded by memory bandwidth rather than
+// FEN parsing.
+
+namespace {
+	// everything the evaluation needs from a position, precomputed once at
+	// convert time: the piece placement, the phase and the pawn structure
+	// counts from Evaluator::pawnFeatures. 80 bytes so records stay aligned
+	struct Record {
+		uint8_t result; //0 = black win, 1 = draw, 2 = white win
+		uint8_t phase; //clamped to 24 like the evaluation blend
+		uint8_t pieceCount;
+		uint8_t padding;
+		std::array<uint16_t, 32> pieces; //color << 9 | (type - 1) << 6 | square
+		int8_t doubled;
+		int8_t isolated;
+		std::array<int8_t, 8> passed;
+		std::array<uint8_t, 2> padding2;
+	};
+
+	static_assert(sizeof(Record) == 80);
+
+	// parameter vector layout: combined material + piece-square value per
+	// midgame/endgame, type and square, then the pawn structure terms
+	constexpr int PSQT = 6 * 64;
+	constexpr int MG_PSQT = 0;
+	constexpr int EG_PSQT = PSQT;
+	constexpr int MG_DOUBLED = 2 * PSQT;
+	constexpr int EG_DOUBLED = MG_DOUBLED + 1;
+	constexpr int MG_ISOLATED = MG_DOUBLED + 2;
+	constexpr int EG_ISOLATED = MG_DOUBLED + 3;
+	constexpr int MG_PASSED = MG_DOUBLED + 4;
+	constexpr int EG_PASSED = MG_PASSED + 8;
+	constexpr int PARAM_COUNT = EG_PASSED + 8;
+
+	std::vector<double> initialParams() {
+		std::vector<double> params(PARAM_COUNT);
+		for (int type = 0; type < 6; ++type) {
+			for (int square = 0; square < 64; ++square) {
+				params[MG_PSQT + type * 64 + square] = mg_value[type] + mg_pesto_table[type][square];
+				params[EG_PSQT + type * 64 + square] = eg_value[type] + eg_pesto_table[type][square];
+			}
+		}
+		params[MG_DOUBLED] = mg_doubled_pawn;
+		params[EG_DOUBLED] = eg_doubled_pawn;
+		params[MG_ISOLATED] = mg_isolated_pawn;
+		params[EG_ISOLATED] = eg_isolated_pawn;
+		for (int i = 0; i < 8; ++i) {
+			params[MG_PASSED + i] = mg_passed_pawn[i];
+			params[EG_PASSED + i] = eg_passed_pawn[i];
+		}
+		return params;
+	}
+
+	// white point of view, on the internal score scale (centipawns times ten)
+	double evaluateRecord(const Record&record, const std::vector<double>&params) {
+		double mg = 0.0;
+		double eg = 0.0;
+
+		for (int i = 0; i < record.pieceCount; ++i) {
+			const uint16_t packed = record.pieces[i];
+			const int sign = (packed >> 9) ? -1 : 1;
+			const int index = packed & 0x1ff;
+			mg += sign * params[MG_PSQT + index];
+			eg += sign * params[EG_PSQT + index];
+		}
+
+		mg += record.doubled * params[MG_DOUBLED] + record.isolated * params[MG_ISOLATED];
+		eg += record.doubled * params[EG_DOUBLED] + record.isolated * params[EG_ISOLATED];
+		for (int i = 0; i < 8; ++i) {
+			mg += record.passed[i] * params[MG_PASSED + i];
+			eg += record.passed[i] * params[EG_PASSED + i];
+		}
+
+		return (mg * record.phase + eg * (24 - record.phase)) / 24.0;
+	}
+
+	bool parseResult(const std::string&line, uint8_t&result) {
+		if (line.find("1-0") != std::string::npos || line.find("1.0") != std::string::npos) result = 2;
+		else if (line.find("0-1") != std::string::npos || line.find("0.0") != std::string::npos) result = 0;
+		else if (line.find("1/2") != std::string::npos || line.find("0.5") != std::string::npos) result = 1;
+		else return false;
+		return true;
+	}
+
+	bool convert(const std::string&textPath, const std::string&binaryPath) {
+		std::ifstream input(textPath);
+		if (!input.is_open()) {
+			printf("failed to open %s\n", textPath.c_str());
+			return false;
+		}
+		std::ofstream output(binaryPath, std::ios::binary);
+		if (!output.is_open()) {
+			printf("failed to open %s\n", binaryPath.c_str());
+			return false;
+		}
+
+		ChessBoard board;
+		std::string line;
+		size_t converted = 0;
+		size_t skipped = 0;
+
+		while (std::getline(input, line)) {
+			if (line.empty()) continue;
+
+			Record record{};
+			if (!parseResult(line, record.result)) {
+				skipped++;
+				continue;
+			}
+
+			// the first six whitespace fields are the FEN, pad the clocks if
+			// the corpus only stores four
+			std::stringstream ss(line);
+			std::string fen, field;
+			int fields = 0;
+			while (fields < 6 && ss >> field && field.find('"') == std::string::npos && field != ";") {
+				fen += (fields > 0 ? " " : "") + field;
+				fields++;
+			}
+			if (fields < 4) {
+				skipped++;
+				continue;
+			}
+			if (fields == 4) fen += " 0 1";
+			if (fields == 5) fen += " 1";
+
+			board.setPosition(fen);
+
+			for (int_fast8_t square = 0; square < 64; ++square) {
+				const Square piece = board.squares[square];
+				if (piece.type == EMPTY) continue;
+				const int_fast8_t tableSquare = (piece.color == WHITE) ? square : flipPosition(square);
+				record.pieces[record.pieceCount++] = (piece.color == BLACK) << 9
+				                                     | (piece.type - 1) << 6
+				                                     | tableSquare;
+			}
+			record.phase = (board.gamePhase > 24) ? 24 : board.gamePhase;
+
+			const Evaluator::PawnFeatures features =
+					Evaluator::pawnFeatures(board.pieces(WHITE, PAWN), board.pieces(BLACK, PAWN));
+			record.doubled = features.doubled;
+			record.isolated = features.isolated;
+			for (int i = 0; i < 8; ++i) record.passed[i] = features.passed[i];
+
+			output.write(reinterpret_cast<const char *>(&record), sizeof(Record));
+			converted++;
+		}
+
+		printf("converted %zu positions (%zu skipped) -> %s\n", converted, skipped, binaryPath.c_str());
+		return output.good();
+	}
+
+	void printTable(FILE* out, const char* name, const std::vector<double>&params, const int offset,
+	                const int materialValue) {
+		fprintf(out, "constexpr std::array<int, 64> %s = {\n", name);
+		for (int rank = 0; rank < 8; ++rank) {
+			fprintf(out, "\t");
+			for (int file = 0; file < 8; ++file) {
+				fprintf(out, "%d, ", (int) std::lround(params[offset + rank * 8 + file]) - materialValue);
+			}
+			fprintf(out, "\n");
+		}
+		fprintf(out, "};\n\n");
+	}
+
+	void emit(const std::string&path, const std::vector<double>&params) {
+		FILE* out = path.empty() ? stdout : fopen(path.c_str(), "w");
+		if (out == nullptr) {
+			printf("failed to open %s\n", path.c_str());
+			return;
+		}
+
+		// material values stay fixed, the tuned combined parameters are split
+		// back into value + table so the output drops into EvaluationValues.h
+		fprintf(out, "constexpr int mg_doubled_pawn = %d;\n", (int) std::lround(params[MG_DOUBLED]));
+		fprintf(out, "constexpr int eg_doubled_pawn = %d;\n", (int) std::lround(params[EG_DOUBLED]));
+		fprintf(out, "constexpr int mg_isolated_pawn = %d;\n", (int) std::lround(params[MG_ISOLATED]));
+		fprintf(out, "constexpr int eg_isolated_pawn = %d;\n", (int) std::lround(params[EG_ISOLATED]));
+		fprintf(out, "constexpr std::array<int, 8> mg_passed_pawn = {");
+		for (int i = 0; i < 8; ++i) fprintf(out, "%d%s", (int) std::lround(params[MG_PASSED + i]), i < 7 ? ", " : "");
+		fprintf(out, "};\n");
+		fprintf(out, "constexpr std::array<int, 8> eg_passed_pawn = {");
+		for (int i = 0; i < 8; ++i) fprintf(out, "%d%s", (int) std::lround(params[EG_PASSED + i]), i < 7 ? ", " : "");
+		fprintf(out, "};\n\n");
+
+		const char* names[6] = {"pawn", "knight", "bishop", "rook", "queen", "king"};
+		for (int type = 0; type < 6; ++type) {
+			char name[32];
+			snprintf(name, sizeof(name), "mg_%s_table", names[type]);
+			printTable(out, name, params, MG_PSQT + type * 64, mg_value[type]);
+			snprintf(name, sizeof(name), "eg_%s_table", names[type]);
+			printTable(out, name, params, EG_PSQT + type * 64, eg_value[type]);
+		}
+
+		if (out != stdout) fclose(out);
+	}
+
+	void tune(const Record* records, const size_t recordCount, const int iterations, const double learningRate,
+	          const double k, const int threadCount, const std::string&outputPath) {
+		std::vector<double> params = initialParams();
+		// sigmoid slope in internal score units
+		const double slope = k * std::log(10.0) / 400.0 / 10.0;
+
+		printf("tuning %zu positions, %d parameters, %d threads\n", recordCount, PARAM_COUNT, threadCount);
+
+		for (int iteration = 0; iteration <= iterations; ++iteration) {
+			std::vector<std::vector<double>> gradients(threadCount, std::vector<double>(PARAM_COUNT));
+			std::vector<double> errors(threadCount);
+
+			const size_t chunk = (recordCount + threadCount - 1) / threadCount;
+			std::vector<std::thread> workers;
+			for (int t = 0; t < threadCount; ++t) {
+				workers.emplace_back([&, t] {
+					std::vector<double>&gradient = gradients[t];
+					double error = 0.0;
+
+					const size_t begin = t * chunk;
+					const size_t end = std::min(begin + chunk, recordCount);
+					for (size_t i = begin; i < end; ++i) {
+						const Record&record = records[i];
+						const double score = evaluateRecord(record, params);
+						const double sigmoid = 1.0 / (1.0 + std::exp(-slope * score));
+						const double target = record.result / 2.0;
+						error += (target - sigmoid) * (target - sigmoid);
+
+						// d(error)/d(param) factors into a per-position scalar
+						// and the feature count times the phase weight
+						const double common = -2.0 * (target - sigmoid) * sigmoid * (1.0 - sigmoid) * slope;
+						const double mgWeight = common * record.phase / 24.0;
+						const double egWeight = common * (24 - record.phase) / 24.0;
+
+						for (int p = 0; p < record.pieceCount; ++p) {
+							const uint16_t packed = record.pieces[p];
+							const int sign = (packed >> 9) ? -1 : 1;
+							const int index = packed & 0x1ff;
+							gradient[MG_PSQT + index] += sign * mgWeight;
+							gradient[EG_PSQT + index] += sign * egWeight;
+						}
+						gradient[MG_DOUBLED] += record.doubled * mgWeight;
+						gradient[EG_DOUBLED] += record.doubled * egWeight;
+						gradient[MG_ISOLATED] += record.isolated * mgWeight;
+						gradient[EG_ISOLATED] += record.isolated * egWeight;
+						for (int r = 0; r < 8; ++r) {
+							gradient[MG_PASSED + r] += record.passed[r] * mgWeight;
+							gradient[EG_PASSED + r] += record.passed[r] * egWeight;
+						}
+					}
+
+					errors[t] = error;
+				});
+			}
+			for (std::thread&worker: workers) worker.join();
+
+			double error = 0.0;
+			for (int t = 0; t < threadCount; ++t) error += errors[t];
+			printf("iteration %3d: error %.6f\n", iteration, error / recordCount);
+
+			if (iteration == iterations) break;
+			for (int t = 0; t < threadCount; ++t) {
+				for (int p = 0; p < PARAM_COUNT; ++p) {
+					params[p] -= learningRate * gradients[t][p] / recordCount;
+				}
+			}
+		}
+
+		emit(outputPath, params);
+	}
+}
+
+int main(const int argc, const char* argv[]) {
+	if (argc < 2) {
+		printf("usage: tuner convert <games.txt> <corpus.bin>\n"
+		       "       tuner <corpus.bin> [iterations N] [lr X] [k K] [threads T] [output F]\n");
+		return 1;
+	}
+
+	if (std::string(argv[1]) == "convert") {
+		if (argc < 4) {
+			printf("usage: tuner convert <games.txt> <corpus.bin>\n");
+			return 1;
+		}
+		return convert(argv[2], argv[3]) ? 0 : 1;
+	}
+
+	int iterations = 100;
+	double learningRate = 100000.0;
+	double k = 1.0;
+	int threadCount = (int) std::thread::hardware_concurrency();
+	std::string outputPath;
+	for (int i = 2; i + 1 < argc; i += 2) {
+		const std::string arg = argv[i];
+		if (arg == "iterations") iterations = std::stoi(argv[i + 1]);
+		else if (arg == "lr") learningRate = std::stod(argv[i + 1]);
+		else if (arg == "k") k = std::stod(argv[i + 1]);
+		else if (arg == "threads") threadCount = std::stoi(argv[i + 1]);
+		else if (arg == "output") outputPath = argv[i + 1];
+	}
+	if (threadCount < 1) threadCount = 1;
+
+	const int fd = open(argv[1], O_RDONLY);
+	if (fd < 0) {
+		printf("failed to open %s\n", argv[1]);
+		return 1;
+	}
+	struct stat info{};
+	if (fstat(fd, &info) < 0 || info.st_size < (off_t) sizeof(Record)) {
+		close(fd);
+		printf("%s is not a corpus file\n", argv[1]);
+		return 1;
+	}
+	void* mapped = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (mapped == MAP_FAILED) {
+		printf("failed to map %s\n", argv[1]);
+		return 1;
+	}
+
+	tune(static_cast<const Record *>(mapped), info.st_size / sizeof(Record), iterations, learningRate, k,
+	     threadCount, outputPath);
+
+	munmap(mapped, info.st_size);
+	return 0;
+}